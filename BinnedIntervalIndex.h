@@ -0,0 +1,314 @@
+#ifndef Binned_Interval_Index_Included
+#define Binned_Interval_Index_Included
+
+#include <vector>
+#include <algorithm>
+#include <unordered_set>
+#include <utility>        /* For std::pair */
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <stdexcept>
+
+/* Hierarchical binning index in the style of the UCSC genome browser,
+   for integer coordinates in a fixed domain [0, domainEnd]. The domain
+   is cut into bins at kNumLevels levels, each bin eight times the size
+   of the ones below it, with a single bin at the top. Every interval is
+   stored in the smallest bin that holds it whole, and each bin keeps
+   its intervals in one contiguous array, so adding an interval is an
+   O(1) append. A point query looks at one bin per level; an interval
+   query at the bins its range touches on each level.
+
+   The finest bins are sized so that the top level covers the domain:
+   a domain of 2^29 gives the 128 kb bins of the UCSC scheme. An
+   interval's id is the order it was added in. Same query interface as
+   CenteredIntervalTree. */
+template <typename Coord = uint32_t, typename Id = int>
+class BinnedIntervalIndex
+{
+  static_assert (std::is_integral<Coord>::value, "Coord must be an integer type");
+  static_assert (std::is_integral<Id>::value, "Id must be an integer type");
+
+  public:
+    typedef Coord coord_type;
+    typedef Id id_type;
+
+    /* Given a list of intervals, constructs a new index holding these
+       elements, for intervals within [0, domainEnd]. A domainEnd of 0
+       means the largest end point among the intervals. Throws
+       std::out_of_range for an interval outside the domain. */
+    BinnedIntervalIndex (const std::vector<std::pair<Coord, Coord> >& intervals,
+                         Coord domainEnd = 0);
+
+    /* Adds an interval in O(1) amortized time and returns its id. Throws
+       std::out_of_range if it lies outside the domain, and
+       std::length_error if there are too many intervals to number with
+       Id. */
+    Id insert (std::pair<Coord, Coord> interval);
+
+    /* Number of intervals in the index */
+    size_t size () const { return contained_intervals.size (); }
+
+    /* Return all the intervals in the index that contain the requested point */
+    std::unordered_set<Id> pointSearch (Coord point) const;
+
+    /* Append the intervals that contain the requested point to 'results' */
+    void pointSearch (Coord point, std::vector<Id>& results) const;
+
+    /* Return all the intervals in the index that overlap the requested interval */
+    std::unordered_set<Id> intervalSearch (std::pair<Coord, Coord> interval) const;
+
+    /* Append the intervals that overlap the requested interval to
+       'results'. An interval whose start is greater than its end
+       overlaps nothing. */
+    void intervalSearch (std::pair<Coord, Coord> interval, std::vector<Id>& results) const;
+
+    /* Call visit (id) for every interval that contains the requested point */
+    template <typename F>
+    void forEachOverlap (Coord point, F&& visit) const;
+
+    /* Call visit (id) for every interval that overlaps the requested interval */
+    template <typename F>
+    void forEachOverlap (std::pair<Coord, Coord> interval, F&& visit) const;
+
+    struct BatchResult;
+
+    /* Answer a point query for each of points[0, count), storing the
+       results in CSR form in 'results' (see BatchResult) */
+    void pointSearchBatch (const Coord* points, size_t count, BatchResult& results) const;
+    void pointSearchBatch (const std::vector<Coord>& points, BatchResult& results) const;
+
+    /* Return the number of intervals that contain the requested point,
+       found by scanning the same bins as a query */
+    Id pointCount (Coord point) const;
+
+    /* Return the number of intervals that overlap the requested interval */
+    Id intervalCount (std::pair<Coord, Coord> interval) const;
+
+    std::vector<std::pair<Coord, Coord> > getStoredIntervalsCopy (void) const;
+
+    static std::string name () {
+      return "Binned Interval Index";
+    }
+
+  private:
+    /* An interval as stored in its bin */
+    struct Entry {
+      Coord start;
+      Coord end;
+      Id id;
+    };
+
+    static const int kNumLevels = 5;
+    static const int kLevelShift = 3;     /* Bins grow 8 times per level */
+
+    /* Helper Functions */
+    uint64_t binIndex (Coord position, int level) const;
+    size_t binOf (Coord start, Coord end) const;
+
+    /* Bit position of the finest level: a bin at level l spans
+       2^(min_shift + 3 l) positions */
+    int min_shift;
+    Coord domain_end;
+
+    /* bins[level_offsets[l] + i] is bin i of level l, finest level first */
+    size_t level_offsets[kNumLevels + 1];
+    std::vector<std::vector<Entry> > bins;
+
+    /* Every interval, by id */
+    std::vector<std::pair<Coord, Coord> > contained_intervals;
+};
+
+/* Results of a batched query in compressed sparse row form: the ids of
+   the intervals matching query i are ids[offsets[i], offsets[i + 1]). */
+template <typename Coord, typename Id>
+struct BinnedIntervalIndex<Coord, Id>::BatchResult
+{
+  std::vector<size_t> offsets;
+  std::vector<Id> ids;
+};
+
+/* * * * * Implementation Below This Point * * * * */
+
+template <typename Coord, typename Id>
+BinnedIntervalIndex<Coord, Id>::BinnedIntervalIndex (const std::vector<std::pair<Coord, Coord> >& intervals,
+                                                     Coord domainEnd)
+  : domain_end (domainEnd)
+{
+  if (domain_end == 0) {
+    for (size_t i = 0; i < intervals.size (); i++) {
+      domain_end = std::max (domain_end, intervals[i].second);
+    }
+  }
+
+  /* The top level needs one bin for all of [0, domain_end] */
+  int bits = 0;
+  while (bits < std::numeric_limits<Coord>::digits && (uint64_t (domain_end) >> bits) != 0) bits++;
+  min_shift = std::max (0, bits - kLevelShift * (kNumLevels - 1));
+
+  level_offsets[0] = 0;
+  for (int level = 0; level < kNumLevels; level++) {
+    level_offsets[level + 1] = level_offsets[level] + binIndex (domain_end, level) + 1;
+  }
+  bins.resize (level_offsets[kNumLevels]);
+
+  contained_intervals.reserve (intervals.size ());
+  for (size_t i = 0; i < intervals.size (); i++) {
+    insert (intervals[i]);
+  }
+}
+
+/* Index within its level of the bin holding 'position' */
+template <typename Coord, typename Id>
+uint64_t
+BinnedIntervalIndex<Coord, Id>::binIndex (Coord position, int level) const
+{
+  int shift = min_shift + kLevelShift * level;
+  return shift >= 64 ? 0 : uint64_t (position) >> shift;
+}
+
+/* The smallest bin holding all of [start, end] */
+template <typename Coord, typename Id>
+size_t
+BinnedIntervalIndex<Coord, Id>::binOf (Coord start, Coord end) const
+{
+  int level = 0;
+  while (level < kNumLevels - 1 && binIndex (start, level) != binIndex (end, level)) level++;
+  return level_offsets[level] + binIndex (start, level);
+}
+
+template <typename Coord, typename Id>
+Id
+BinnedIntervalIndex<Coord, Id>::insert (std::pair<Coord, Coord> interval)
+{
+  if (interval.first < 0 || interval.first > interval.second || interval.second > domain_end) {
+    throw std::out_of_range ("Interval outside the binned domain");
+  }
+  if (contained_intervals.size () >= (size_t) std::numeric_limits<Id>::max ()) {
+    throw std::length_error ("Too many intervals for the id type");
+  }
+
+  Id id = contained_intervals.size ();
+  Entry entry = { interval.first, interval.second, id };
+  bins[binOf (interval.first, interval.second)].push_back (entry);
+  contained_intervals.push_back (interval);
+  return id;
+}
+
+/* On every level, scans the bins from the one holding the query start
+   to the one holding its end */
+template <typename Coord, typename Id>
+template <typename F>
+void
+BinnedIntervalIndex<Coord, Id>::forEachOverlap (std::pair<Coord, Coord> interval, F&& visit) const
+{
+  if (interval.first > interval.second || interval.second < 0 || interval.first > domain_end) {
+    return;
+  }
+  const Coord start = std::max (interval.first, Coord (0));
+  const Coord end = std::min (interval.second, domain_end);
+
+  for (int level = 0; level < kNumLevels; level++) {
+    size_t first = level_offsets[level] + binIndex (start, level);
+    size_t last = level_offsets[level] + binIndex (end, level);
+    for (size_t bin = first; bin <= last; bin++) {
+      const Entry* entries = bins[bin].data ();
+      size_t count = bins[bin].size ();
+      for (size_t i = 0; i < count; i++) {
+        if (entries[i].start <= interval.second && interval.first <= entries[i].end) {
+          visit (entries[i].id);
+        }
+      }
+    }
+  }
+}
+
+template <typename Coord, typename Id>
+template <typename F>
+void
+BinnedIntervalIndex<Coord, Id>::forEachOverlap (Coord point, F&& visit) const
+{
+  forEachOverlap (std::make_pair (point, point), visit);
+}
+
+template <typename Coord, typename Id>
+std::unordered_set<Id>
+BinnedIntervalIndex<Coord, Id>::pointSearch (Coord point) const
+{
+  std::unordered_set<Id> intervals;
+  forEachOverlap (point, [&intervals] (Id id) { intervals.insert (id); });
+  return intervals;
+}
+
+template <typename Coord, typename Id>
+void
+BinnedIntervalIndex<Coord, Id>::pointSearch (Coord point, std::vector<Id>& results) const
+{
+  forEachOverlap (point, [&results] (Id id) { results.push_back (id); });
+}
+
+template <typename Coord, typename Id>
+std::unordered_set<Id>
+BinnedIntervalIndex<Coord, Id>::intervalSearch (std::pair<Coord, Coord> interval) const
+{
+  std::unordered_set<Id> overlaps;
+  forEachOverlap (interval, [&overlaps] (Id id) { overlaps.insert (id); });
+  return overlaps;
+}
+
+template <typename Coord, typename Id>
+void
+BinnedIntervalIndex<Coord, Id>::intervalSearch (std::pair<Coord, Coord> interval,
+                                                std::vector<Id>& results) const
+{
+  forEachOverlap (interval, [&results] (Id id) { results.push_back (id); });
+}
+
+template <typename Coord, typename Id>
+void
+BinnedIntervalIndex<Coord, Id>::pointSearchBatch (const Coord* points, size_t count,
+                                                  BatchResult& results) const
+{
+  results.offsets.resize (count + 1);
+  results.ids.clear ();
+  for (size_t i = 0; i < count; i++) {
+    results.offsets[i] = results.ids.size ();
+    pointSearch (points[i], results.ids);
+  }
+  results.offsets[count] = results.ids.size ();
+}
+
+template <typename Coord, typename Id>
+void
+BinnedIntervalIndex<Coord, Id>::pointSearchBatch (const std::vector<Coord>& points,
+                                                  BatchResult& results) const
+{
+  pointSearchBatch (points.data (), points.size (), results);
+}
+
+template <typename Coord, typename Id>
+Id
+BinnedIntervalIndex<Coord, Id>::pointCount (Coord point) const
+{
+  return intervalCount (std::make_pair (point, point));
+}
+
+template <typename Coord, typename Id>
+Id
+BinnedIntervalIndex<Coord, Id>::intervalCount (std::pair<Coord, Coord> interval) const
+{
+  Id count = 0;
+  forEachOverlap (interval, [&count] (Id) { count++; });
+  return count;
+}
+
+template <typename Coord, typename Id>
+std::vector<std::pair<Coord, Coord> >
+BinnedIntervalIndex<Coord, Id>::getStoredIntervalsCopy (void) const
+{
+  return contained_intervals;
+}
+
+#endif
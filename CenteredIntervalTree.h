@@ -2,64 +2,1249 @@
 #define Centered_Interval_Tree_Included
 
 #include <vector>
+#include <algorithm>
 #include <unordered_set>
 #include <utility>        /* For std::pair */
 #include <tuple>
 #include <string>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <limits>
+#include <type_traits>
+#include <stdexcept>
+#include <iostream>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "EndpointScan.h"
+#include "SortedSearch.h"
+#include "StorageArray.h"
+#include "ParallelSort.h"
+#include "RadixSort.h"
 
-/* Static Centered Interval Tree with support for query, no insertion or deletion */
+/* Static Centered Interval Tree with support for query, no insertion or deletion.
+   Queries never modify the tree, so any number of threads may query one
+   tree at the same time.
+
+   Coord is the type of the interval endpoints and Id the integer type
+   used to number the intervals and index the tree's arrays; a tree of
+   32-bit positions with 32-bit ids stores 8 bytes of endpoint keys and
+   ids per interval where a double tree stores 12. The double/int tree
+   is compiled once in CenteredIntervalTree.cpp.
+
+   Payload, if given, is a value stored with every interval, such as the
+   caller's own record or a stable id of theirs, and handed back by the
+   payload queries in place of the tree's ids. */
+struct NoPayload {};
+
+template <typename Coord = double, typename Id = int, typename Payload = NoPayload>
 class CenteredIntervalTree
 {
+  static_assert (std::is_arithmetic<Coord>::value, "Coord must be an arithmetic type");
+  static_assert (std::is_integral<Id>::value, "Id must be an integer type");
+
   public:
+    typedef Coord coord_type;
+    typedef Id id_type;
+    typedef Payload payload_type;
+
+    /* Order in which the nodes of the tree are laid out in memory.
+       Breadth-first keeps each level together; van Emde Boas recursively
+       groups subtrees of half the height so that a root-to-leaf walk
+       touches O(log_B n) cache lines regardless of line size. */
+    enum Layout {
+      kBreadthFirst,
+      kVanEmdeBoas
+    };
+
+    /* Opens a tree written by saveSnapshot. The file is mapped read-only
+       and queried in place, with no deserialization; processes that open
+       the same file share its pages. Throws std::runtime_error if the
+       file cannot be mapped, is not a snapshot of this version and
+       these Coord, Id and Payload types, or holds a child index, node
+       run or id outside the tree. Opening checks every node and id, in
+       time linear in the size of the tree. */
+    explicit CenteredIntervalTree (const std::string& snapshotPath);
+
     /* Given a list of intervals, constructs a new interval tree holding
-       these elements */
-    CenteredIntervalTree (const std::vector<std::pair<double, double> >& intervals);
+       these elements. With numThreads > 1 the sorts and the recursive
+       build are spread over that many threads; the resulting tree is
+       identical to the single-threaded one. Throws std::length_error if
+       there are too many intervals to number with Id. */
+    CenteredIntervalTree (const std::vector<std::pair<Coord, Coord> >& intervals,
+                          Layout layout = kBreadthFirst, unsigned numThreads = 1);
 
-    /* Destructor for the interval tree */
-    ~CenteredIntervalTree ();
+    /* As above, storing payloads[i] with intervals[i]. Throws
+       std::invalid_argument if the two lists differ in length. Without
+       payloads every interval gets Payload (). */
+    CenteredIntervalTree (const std::vector<std::pair<Coord, Coord> >& intervals,
+                          const std::vector<Payload>& payloads,
+                          Layout layout = kBreadthFirst, unsigned numThreads = 1);
 
     /* Return all the intervals in the tree that contain the requested point */
-    std::unordered_set<int> pointSearch (double point);
+    std::unordered_set<Id> pointSearch (Coord point) const;
+
+    /* Append the intervals that contain the requested point to 'results'.
+       Each interval is reported once, and nothing is allocated once
+       'results' has grown to the size of the answer. */
+    void pointSearch (Coord point, std::vector<Id>& results) const;
+
+    /* Call visit (id) for every interval that contains the requested point */
+    template <typename F>
+    void forEachOverlap (Coord point, F&& visit) const;
 
     /* Return all the intervals in the tree that overlap the requested interval */
-    std::unordered_set<int> intervalSearch (std::pair<double, double> interval);
+    std::unordered_set<Id> intervalSearch (std::pair<Coord, Coord> interval) const;
+
+    /* Append the intervals that overlap the requested interval to
+       'results'. Each interval is reported exactly once, so no
+       deduplication is needed. An interval whose start is greater than
+       its end overlaps nothing. */
+    void intervalSearch (std::pair<Coord, Coord> interval, std::vector<Id>& results) const;
+
+    /* Call visit (id) for every interval that overlaps the requested interval */
+    template <typename F>
+    void forEachOverlap (std::pair<Coord, Coord> interval, F&& visit) const;
+
+    /* Call visit (payload) with a reference to the payload of every
+       interval that contains the requested point. The payloads are
+       stored alongside the ids in each order the queries read them in,
+       so they are read in runs rather than looked up one at a time. */
+    template <typename F>
+    void forEachPayload (Coord point, F&& visit) const;
 
-    std::vector<std::pair<double, double> > returnIntervals (std::unordered_set<int>& overlaps);
+    /* Call visit (payload) for every interval that overlaps the requested
+       interval */
+    template <typename F>
+    void forEachPayload (std::pair<Coord, Coord> interval, F&& visit) const;
 
-    std::vector<std::pair<double, double> > getStoredIntervalsCopy (void);
+    /* The payload stored with interval 'id' */
+    const Payload& payload (Id id) const { return contained_payloads[id]; }
 
-    void printTree (void);
+    struct BatchResult;
+
+    /* Answer a point query for each of points[0, count) at once, storing
+       the results in CSR form in 'results' (see BatchResult). The probes
+       are sorted, unless the caller says they already are, and the tree
+       is walked once for the whole batch: at each node the probes are
+       split at the key and share one pass over the node's endpoints. */
+    void pointSearchBatch (const Coord* points, size_t count, BatchResult& results,
+                           bool presorted = false) const;
+    void pointSearchBatch (const std::vector<Coord>& points, BatchResult& results,
+                           bool presorted = false) const;
+
+    /* Return the number of intervals that contain the requested point,
+       computed from two binary searches without visiting the tree */
+    Id pointCount (Coord point) const;
+
+    /* Return the number of intervals that overlap the requested interval */
+    Id intervalCount (std::pair<Coord, Coord> interval) const;
+
+    std::vector<std::pair<Coord, Coord> > returnIntervals (const std::unordered_set<Id>& overlaps) const;
+
+    class IntervalView;
+
+    /* Returns a view of the stored intervals named by 'overlaps' that
+       looks them up on access instead of copying them. The view refers to
+       'overlaps' and to this tree, so it must not outlive either. */
+    IntervalView returnIntervals (const std::vector<Id>& overlaps) const;
+
+    std::vector<std::pair<Coord, Coord> > getStoredIntervalsCopy (void) const;
+
+    /* Writes the built tree to 'path' in the snapshot format read by the
+       snapshot constructor. Throws std::runtime_error on I/O failure. */
+    void saveSnapshot (const std::string& path) const;
+
+    void printTree (void) const;
 
     static std::string name () {
       return "Centered Interval Tree";
     }
 
   private:
+    /* A node of the flattened tree. Children are indices into 'nodes'
+       (kNoChild when absent) and the intervals containing 'key' occupy
+       [begin, begin + count) of the start and end endpoint arrays. */
     struct Node {
-      double key;
-      Node *left;
-      Node *right;
-      std::vector<std::tuple<double, double, int> > sorted_starts;
-      std::vector<std::tuple<double, double, int> > sorted_ends;
+      Coord key;
+      Id left;
+      Id right;
+      Id begin;
+      Id count;
     };
 
-    Node* root; /* Root of interval tree */
+    static constexpr Id kNoChild = static_cast<Id> (-1);
+
+    /* All nodes of the tree in layout order; the root is nodes[0] */
+    StorageArray<Node> nodes;
+
+    /* Intervals stored at each node as parallel key and id arrays, sorted
+       by start and by end respectively. Every node owns one contiguous
+       run of all four arrays, so a scan only loads the keys it compares. */
+    StorageArray<Coord> start_keys;
+    StorageArray<Id> start_ids;
+    StorageArray<Coord> end_keys;
+    StorageArray<Id> end_ids;
+
+    /* Whether Payload is a real payload type; NoPayload trees leave every
+       payload array empty */
+    static constexpr bool kHasPayloads = !std::is_same<Payload, NoPayload>::value;
+
+    /* The payloads of the intervals in each of the orders above, so a run
+       of ids found by a query is also a run of payloads */
+    StorageArray<Payload> start_payloads;
+    StorageArray<Payload> end_payloads;
+
+    /* Header of a snapshot file; see saveSnapshot */
+    struct SnapshotHeader {
+      char magic[8];
+      uint32_t version;
+      uint32_t byte_order;
+      uint32_t coord_size;
+      uint32_t id_size;
+      uint32_t node_size;
+      uint32_t coord_kind;
+      uint32_t payload_size;    /* 0 for NoPayload */
+      uint32_t reserved;
+      uint64_t num_intervals;
+      uint64_t num_nodes;
+    };
+
+    static constexpr char kSnapshotMagic[8] = { 'C', 'I', 'T', 'S', 'N', 'A', 'P', '\0' };
+    static constexpr uint32_t kSnapshotVersion = 2;
+    static constexpr uint32_t kSnapshotByteOrder = 0x01020304;
+    static constexpr size_t kSnapshotAlignment = 64;
 
     /* Helper Functions */
-    Node* buildTree (std::vector<std::tuple<double, double, int> >& sorted_ends);
-    Node* newNode (double key, Node* left, Node* right,
-                   std::vector<std::tuple<double, double, int> >& sorted_starts,
-                   std::vector<std::tuple<double, double, int> >& sorted_ends);
-    void pointSearchHelper (Node* rootNode, double point, std::unordered_set<int>& intervals);
-    int findStartIndex (double start, int left, int right);
-    int findEndIndex (double end, int left, int right);
-    void traverse (Node* rootNode);
-    void printTupleVec (std::vector<std::tuple<double, double, int> >& vec);
-    void printPairVec (std::vector<std::pair<double, double> >& vec);
+    static bool sortBySec (const std::pair<Coord, Coord>& a, const std::pair<Coord, Coord>& b);
+    static int parallelDepth (unsigned numThreads);
+    static uint32_t snapshotCoordKind ();
+    static uint32_t snapshotPayloadSize ();
+    static size_t alignSnapshotOffset (size_t offset);
+    void build (const std::vector<Payload>* payloads, Layout layout, unsigned numThreads);
+    void sortIntervals (const std::vector<Payload>* payloads, ThreadPool& pool);
+    Id buildTree (Id lo, Id hi, std::vector<Id>& scratch, std::vector<Node>& tree,
+                  ThreadPool& pool, int spawnDepth);
+    Id newNode (Coord key, Id left, Id right, Id begin, Id count, std::vector<Node>& tree);
+    void fillStartOrders (const std::vector<Node>& tree, std::vector<Id>& scratch);
+    Id appendSubtree (const std::vector<Node>& subtree, Id subtreeRoot, std::vector<Node>& tree);
+    void layoutTree (std::vector<Node>& tree, Id treeRoot, Layout layout);
+    void layoutVanEmdeBoas (const std::vector<Node>& tree, Id rootNode, int height,
+                            std::vector<Id>& order);
+    int subtreeHeight (const std::vector<Node>& tree, Id rootNode);
+    void pointSearchHelper (Coord point, std::unordered_set<Id>& intervals) const;
+    template <typename F>
+    void forEachSlice (Coord point, F&& visitSlice) const;
+    template <typename F>
+    void forEachSlice (std::pair<Coord, Coord> interval, F&& visitSlice) const;
+    template <typename F>
+    void forEachRun (Coord point, F&& visitRun) const;
+    template <typename F>
+    void forEachRun (std::pair<Coord, Coord> interval, F&& visitRun) const;
+    template <typename F>
+    void forEachBatchRun (Id rootNode, const std::pair<Coord, size_t>* probes,
+                          size_t count, F& visitRun) const;
+    void traverse (Id rootNode) const;
+    void printTupleVec (const std::vector<std::tuple<Coord, Coord, Id> >& vec) const;
+    void printPairVec (const std::vector<std::pair<Coord, Coord> >& vec) const;
 
     /* Set of intervals used to construct interval tree */
-    std::vector<std::pair<double, double> > contained_intervals;
-    std::vector<std::pair<double, double> > combined_points;
+    StorageArray<std::pair<Coord, Coord> > contained_intervals;
+
+    /* Every interval, sorted by start point */
+    StorageArray<Coord> sorted_start_keys;
+    StorageArray<Id> sorted_start_ids;
+
+    /* End points of every interval in ascending order */
+    StorageArray<Coord> sorted_end_keys;
+
+    /* Payloads in id order, and in the order of sorted_start_ids */
+    StorageArray<Payload> contained_payloads;
+    StorageArray<Payload> sorted_start_payloads;
+
+    /* The mapped snapshot file the arrays view, if any */
+    std::shared_ptr<const void> mapping;
+};
+
+/* Results of a batched query in compressed sparse row form: the ids of
+   the intervals matching query i are ids[offsets[i], offsets[i + 1]).
+   Reusing one BatchResult across batches avoids reallocating it. */
+template <typename Coord, typename Id, typename Payload>
+struct CenteredIntervalTree<Coord, Id, Payload>::BatchResult
+{
+  std::vector<size_t> offsets;
+  std::vector<Id> ids;
+
+  /* Probes sorted by value, paired with their index in the batch */
+  std::vector<std::pair<Coord, size_t> > probes;
 };
 
+/* Read-only view of a list of stored intervals, given by their ids */
+template <typename Coord, typename Id, typename Payload>
+class CenteredIntervalTree<Coord, Id, Payload>::IntervalView
+{
+  public:
+    class const_iterator {
+      public:
+        const_iterator (const std::pair<Coord, Coord>* intervals, const Id* id)
+          : intervals (intervals), id (id) {}
+
+        const std::pair<Coord, Coord>& operator* () const { return intervals[*id]; }
+        const std::pair<Coord, Coord>* operator-> () const { return &**this; }
+        const_iterator& operator++ () { ++id; return *this; }
+        bool operator== (const const_iterator& rhs) const { return id == rhs.id; }
+        bool operator!= (const const_iterator& rhs) const { return id != rhs.id; }
+
+      private:
+        const std::pair<Coord, Coord>* intervals;
+        const Id* id;
+    };
+
+    IntervalView (const std::pair<Coord, Coord>* intervals, const std::vector<Id>& ids)
+      : intervals (intervals), ids (&ids) {}
+
+    size_t size () const { return ids->size (); }
+    const std::pair<Coord, Coord>& operator[] (size_t i) const { return intervals[(*ids)[i]]; }
+    const_iterator begin () const { return const_iterator (intervals, ids->data ()); }
+    const_iterator end () const { return const_iterator (intervals, ids->data () + ids->size ()); }
+
+  private:
+    const std::pair<Coord, Coord>* intervals;
+    const std::vector<Id>* ids;
+};
+
+/* The double/int tree is instantiated once, in CenteredIntervalTree.cpp */
+extern template class CenteredIntervalTree<double, int>;
+
+/* * * * * Implementation Below This Point * * * * */
+
+/* Comparator function for sorting containers with
+   pair<T, T> elements. Ties on the second element are broken by the
+   first, so that every sort of the same input gives the same order. */
+template <typename Coord, typename Id, typename Payload>
+bool
+CenteredIntervalTree<Coord, Id, Payload>::sortBySec (const std::pair<Coord, Coord>& a,
+                                                     const std::pair<Coord, Coord>& b)
+{
+  if (a.second != b.second) return a.second < b.second;
+  return a.first < b.first;
+}
+
+/* Number of levels of the recursive build that fork a task per subtree:
+   enough for a few tasks per thread, so uneven subtrees balance out */
+template <typename Coord, typename Id, typename Payload>
+int
+CenteredIntervalTree<Coord, Id, Payload>::parallelDepth (unsigned numThreads)
+{
+  int depth = 0;
+  while (numThreads > 1) {
+    numThreads /= 2;
+    depth++;
+  }
+  return depth == 0 ? 0 : depth + 2;
+}
+
+template <typename Coord, typename Id, typename Payload>
+CenteredIntervalTree<Coord, Id, Payload>::CenteredIntervalTree (const std::vector<std::pair<Coord, Coord> >& intervals,
+                                                                Layout layout, unsigned numThreads)
+  : contained_intervals (intervals)
+{
+  build (nullptr, layout, numThreads);
+}
+
+template <typename Coord, typename Id, typename Payload>
+CenteredIntervalTree<Coord, Id, Payload>::CenteredIntervalTree (const std::vector<std::pair<Coord, Coord> >& intervals,
+                                                                const std::vector<Payload>& payloads,
+                                                                Layout layout, unsigned numThreads)
+  : contained_intervals (intervals)
+{
+  if (payloads.size () != intervals.size ()) {
+    throw std::invalid_argument ("Need one payload per interval");
+  }
+  build (&payloads, layout, numThreads);
+}
+
+/* Sorts contained_intervals by end point, carrying the payloads along
+   into contained_payloads. An interval's index in this order is its id.
+   Integer coordinates are radix sorted in linear time, by start and then
+   stably by end. */
+template <typename Coord, typename Id, typename Payload>
+void
+CenteredIntervalTree<Coord, Id, Payload>::sortIntervals (const std::vector<Payload>* payloads,
+                                                         ThreadPool& pool)
+{
+  if constexpr (!kHasPayloads) {
+    if constexpr (std::is_integral<Coord>::value) {
+      radixSort (contained_intervals.begin (), contained_intervals.end (),
+                 [] (const std::pair<Coord, Coord>& interval) { return interval.first; });
+      radixSort (contained_intervals.begin (), contained_intervals.end (),
+                 [] (const std::pair<Coord, Coord>& interval) { return interval.second; });
+    }
+    else {
+      parallelSort (contained_intervals.begin (), contained_intervals.end (), sortBySec, pool);
+    }
+  }
+  else {
+    /* Sort the intervals tagged with their input position, then gather
+       the payloads in the sorted order */
+    typedef std::pair<std::pair<Coord, Coord>, Id> Tagged;
+    Id n = contained_intervals.size ();
+    std::vector<Tagged> tagged (n);
+    for (Id i = 0; i < n; i++) {
+      tagged[i] = std::make_pair (contained_intervals[i], i);
+    }
+    if constexpr (std::is_integral<Coord>::value) {
+      radixSort (tagged.data (), tagged.data () + n,
+                 [] (const Tagged& item) { return item.first.first; });
+      radixSort (tagged.data (), tagged.data () + n,
+                 [] (const Tagged& item) { return item.first.second; });
+    }
+    else {
+      parallelSort (tagged.begin (), tagged.end (), [] (const Tagged& a, const Tagged& b) {
+        if (a.first != b.first) return sortBySec (a.first, b.first);
+        return a.second < b.second;
+      }, pool);
+    }
+
+    contained_payloads.resize (n);
+    for (Id i = 0; i < n; i++) {
+      contained_intervals[i] = tagged[i].first;
+      if (payloads) contained_payloads[i] = (*payloads)[tagged[i].second];
+    }
+  }
+}
+
+/* Builds the tree over contained_intervals, which holds the input
+   intervals, and 'payloads' if given */
+template <typename Coord, typename Id, typename Payload>
+void
+CenteredIntervalTree<Coord, Id, Payload>::build (const std::vector<Payload>* payloads,
+                                                 Layout layout, unsigned numThreads)
+{
+  /* Every id and the kNoChild marker must be distinct values of Id */
+  if (contained_intervals.size () >= (size_t) std::numeric_limits<Id>::max ()) {
+    throw std::length_error ("Too many intervals for the id type");
+  }
+
+  ThreadPool pool (numThreads > 1 ? numThreads - 1 : 0);
+  Id n = contained_intervals.size ();
+
+  sortIntervals (payloads, pool);
+
+  /* Global orders of start and end points. Starts are sorted paired
+     with their ids, which breaks ties by id. */
+  std::vector<std::pair<Coord, Id> > starts (n);
+  for (Id i = 0; i < n; i++) {
+    starts[i] = std::make_pair (contained_intervals[i].first, i);
+  }
+  if constexpr (std::is_integral<Coord>::value) {
+    radixSort (starts.data (), starts.data () + n,
+               [] (const std::pair<Coord, Id>& start) { return start.first; });
+  }
+  else {
+    parallelSort (starts.begin (), starts.end (), pool);
+  }
+  sorted_start_keys.resize (n);
+  sorted_start_ids.resize (n);
+  sorted_end_keys.resize (n);
+  for (Id i = 0; i < n; i++) {
+    sorted_start_keys[i] = starts[i].first;
+    sorted_start_ids[i] = starts[i].second;
+    sorted_end_keys[i] = contained_intervals[i].second;
+  }
+  std::vector<std::pair<Coord, Id> > ().swap (starts);
+  if constexpr (kHasPayloads) {
+    sorted_start_payloads.resize (n);
+    for (Id i = 0; i < n; i++) {
+      sorted_start_payloads[i] = contained_payloads[sorted_start_ids[i]];
+    }
+  }
+
+  /* end_ids starts out as every id in end order and is partitioned in
+     place by buildTree until each node owns one run of it */
+  start_keys.resize (n);
+  start_ids.resize (n);
+  end_keys.resize (n);
+  end_ids.resize (n);
+  for (Id i = 0; i < n; i++) {
+    end_ids[i] = i;
+  }
+  if constexpr (kHasPayloads) {
+    start_payloads.resize (n);
+    end_payloads.resize (n);
+  }
+
+  /* Build the tree in recursion order, then flatten it into the
+     requested layout */
+  std::vector<Id> scratch (n);
+  std::vector<Node> tree;
+  Id treeRoot = buildTree (0, n, scratch, tree, pool, parallelDepth (numThreads));
+  fillStartOrders (tree, scratch);
+  layoutTree (tree, treeRoot, layout);
+}
+
+/* 0 for floating point coordinates, 1 for signed and 2 for unsigned
+   integers */
+template <typename Coord, typename Id, typename Payload>
+uint32_t
+CenteredIntervalTree<Coord, Id, Payload>::snapshotCoordKind ()
+{
+  if (std::is_floating_point<Coord>::value) return 0;
+  return std::is_signed<Coord>::value ? 1 : 2;
+}
+
+template <typename Coord, typename Id, typename Payload>
+uint32_t
+CenteredIntervalTree<Coord, Id, Payload>::snapshotPayloadSize ()
+{
+  return kHasPayloads ? sizeof (Payload) : 0;
+}
+
+template <typename Coord, typename Id, typename Payload>
+size_t
+CenteredIntervalTree<Coord, Id, Payload>::alignSnapshotOffset (size_t offset)
+{
+  return (offset + kSnapshotAlignment - 1) / kSnapshotAlignment * kSnapshotAlignment;
+}
+
+template <typename Coord, typename Id, typename Payload>
+CenteredIntervalTree<Coord, Id, Payload>::CenteredIntervalTree (const std::string& snapshotPath)
+{
+  if constexpr (kHasPayloads) {
+    static_assert (std::is_trivially_copyable<Payload>::value,
+                   "Snapshots need a trivially copyable Payload");
+  }
+
+  int fd = open (snapshotPath.c_str (), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error ("Cannot open snapshot " + snapshotPath);
+  }
+  struct stat info;
+  if (fstat (fd, &info) != 0 || (size_t) info.st_size < sizeof (SnapshotHeader)) {
+    close (fd);
+    throw std::runtime_error ("Not a snapshot: " + snapshotPath);
+  }
+  size_t length = info.st_size;
+  void* address = mmap (nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+  close (fd);
+  if (address == MAP_FAILED) {
+    throw std::runtime_error ("Cannot map snapshot " + snapshotPath);
+  }
+  mapping = std::shared_ptr<const void> (address, [length] (const void* memory) {
+    munmap (const_cast<void*> (memory), length);
+  });
+
+  const char* base = static_cast<const char*> (address);
+  SnapshotHeader header;
+  std::memcpy (&header, base, sizeof (header));
+  if (std::memcmp (header.magic, kSnapshotMagic, sizeof (kSnapshotMagic)) != 0 ||
+      header.version != kSnapshotVersion || header.byte_order != kSnapshotByteOrder ||
+      header.coord_size != sizeof (Coord) || header.coord_kind != snapshotCoordKind () ||
+      header.id_size != sizeof (Id) || header.node_size != sizeof (Node) ||
+      header.payload_size != snapshotPayloadSize () ||
+      header.num_intervals > length || header.num_nodes > length) {
+    throw std::runtime_error ("Not a compatible snapshot: " + snapshotPath);
+  }
+
+  /* Hands back the next array of the file, checking that it is all there */
+  size_t offset = sizeof (header);
+  auto section = [&] (size_t bytes) {
+    size_t start = alignSnapshotOffset (offset);
+    if (start + bytes > length) {
+      throw std::runtime_error ("Truncated snapshot: " + snapshotPath);
+    }
+    offset = start + bytes;
+    return base + start;
+  };
+
+  size_t n = header.num_intervals;
+  size_t numNodes = header.num_nodes;
+  nodes.attach (reinterpret_cast<const Node*> (section (numNodes * sizeof (Node))), numNodes);
+  contained_intervals.attach (reinterpret_cast<const std::pair<Coord, Coord>*> (
+                                section (n * sizeof (std::pair<Coord, Coord>))), n);
+  start_keys.attach (reinterpret_cast<const Coord*> (section (n * sizeof (Coord))), n);
+  start_ids.attach (reinterpret_cast<const Id*> (section (n * sizeof (Id))), n);
+  end_keys.attach (reinterpret_cast<const Coord*> (section (n * sizeof (Coord))), n);
+  end_ids.attach (reinterpret_cast<const Id*> (section (n * sizeof (Id))), n);
+  sorted_start_keys.attach (reinterpret_cast<const Coord*> (section (n * sizeof (Coord))), n);
+  sorted_start_ids.attach (reinterpret_cast<const Id*> (section (n * sizeof (Id))), n);
+  sorted_end_keys.attach (reinterpret_cast<const Coord*> (section (n * sizeof (Coord))), n);
+  if constexpr (kHasPayloads) {
+    contained_payloads.attach (reinterpret_cast<const Payload*> (section (n * sizeof (Payload))), n);
+    start_payloads.attach (reinterpret_cast<const Payload*> (section (n * sizeof (Payload))), n);
+    end_payloads.attach (reinterpret_cast<const Payload*> (section (n * sizeof (Payload))), n);
+    sorted_start_payloads.attach (reinterpret_cast<const Payload*> (section (n * sizeof (Payload))),
+                                  n);
+  }
+
+  /* Queries index the arrays with what the file says, unchecked, so a
+     file that is damaged past its header is rejected here. Both layouts
+     put every node before its children, which also rules out cycles. */
+  for (size_t i = 0; i < numNodes; i++) {
+    const Node& node = nodes[i];
+    if ((node.left != kNoChild && ((size_t) node.left <= i || (size_t) node.left >= numNodes)) ||
+        (node.right != kNoChild && ((size_t) node.right <= i || (size_t) node.right >= numNodes)) ||
+        (size_t) node.begin > n || (size_t) node.count > n - (size_t) node.begin) {
+      throw std::runtime_error ("Corrupt snapshot: " + snapshotPath);
+    }
+  }
+  for (size_t i = 0; i < n; i++) {
+    if ((size_t) start_ids[i] >= n || (size_t) end_ids[i] >= n || (size_t) sorted_start_ids[i] >= n) {
+      throw std::runtime_error ("Corrupt snapshot: " + snapshotPath);
+    }
+  }
+}
+
+/* Snapshot file layout: a SnapshotHeader followed by the tree's arrays,
+   each starting at a multiple of kSnapshotAlignment, in the order
+   nodes, contained_intervals, start_keys, start_ids, end_keys, end_ids,
+   sorted_start_keys, sorted_start_ids, sorted_end_keys, then for trees
+   with payloads contained_payloads, start_payloads, end_payloads and
+   sorted_start_payloads. Arrays are stored in the in-memory layout of
+   the build that wrote them; the header records that layout, including
+   the kind and size of Coord and Id and the size of Payload, so that
+   other builds and other instantiations reject the file. Payloads are
+   written byte for byte, so they must be trivially copyable. */
+template <typename Coord, typename Id, typename Payload>
+void
+CenteredIntervalTree<Coord, Id, Payload>::saveSnapshot (const std::string& path) const
+{
+  std::ofstream out (path.c_str (), std::ios::binary | std::ios::trunc);
+  if (!out) {
+    throw std::runtime_error ("Cannot create snapshot " + path);
+  }
+
+  SnapshotHeader header;
+  std::memset (&header, 0, sizeof (header));
+  std::memcpy (header.magic, kSnapshotMagic, sizeof (kSnapshotMagic));
+  header.version = kSnapshotVersion;
+  header.byte_order = kSnapshotByteOrder;
+  header.coord_size = sizeof (Coord);
+  header.id_size = sizeof (Id);
+  header.node_size = sizeof (Node);
+  header.coord_kind = snapshotCoordKind ();
+  header.payload_size = snapshotPayloadSize ();
+  header.num_intervals = contained_intervals.size ();
+  header.num_nodes = nodes.size ();
+  out.write (reinterpret_cast<const char*> (&header), sizeof (header));
+
+  size_t offset = sizeof (header);
+  auto section = [&] (const void* data, size_t bytes) {
+    static const char padding[kSnapshotAlignment] = {};
+    size_t start = alignSnapshotOffset (offset);
+    out.write (padding, start - offset);
+    out.write (static_cast<const char*> (data), bytes);
+    offset = start + bytes;
+  };
+
+  size_t n = contained_intervals.size ();
+  section (nodes.data (), nodes.size () * sizeof (Node));
+  section (contained_intervals.data (), n * sizeof (std::pair<Coord, Coord>));
+  section (start_keys.data (), n * sizeof (Coord));
+  section (start_ids.data (), n * sizeof (Id));
+  section (end_keys.data (), n * sizeof (Coord));
+  section (end_ids.data (), n * sizeof (Id));
+  section (sorted_start_keys.data (), n * sizeof (Coord));
+  section (sorted_start_ids.data (), n * sizeof (Id));
+  section (sorted_end_keys.data (), n * sizeof (Coord));
+  if constexpr (kHasPayloads) {
+    static_assert (std::is_trivially_copyable<Payload>::value,
+                   "Snapshots need a trivially copyable Payload");
+    section (contained_payloads.data (), n * sizeof (Payload));
+    section (start_payloads.data (), n * sizeof (Payload));
+    section (end_payloads.data (), n * sizeof (Payload));
+    section (sorted_start_payloads.data (), n * sizeof (Payload));
+  }
+
+  out.close ();
+  if (!out) {
+    throw std::runtime_error ("Cannot write snapshot " + path);
+  }
+}
+
+/* Appends a new node owning [begin, begin + count) of the endpoint arrays
+   to the tree under construction and returns its index. end_ids already
+   holds the node's intervals in end order; their end keys and payloads
+   are filled in from it, and the start order later by fillStartOrders. */
+template <typename Coord, typename Id, typename Payload>
+Id
+CenteredIntervalTree<Coord, Id, Payload>::newNode (Coord key, Id left, Id right, Id begin, Id count,
+                                                   std::vector<Node>& tree)
+{
+  Node temp;
+  temp.key = key;
+  temp.left = left;
+  temp.right = right;
+  temp.begin = begin;
+  temp.count = count;
+
+  for (Id i = begin; i < begin + count; i++) {
+    end_keys[i] = contained_intervals[end_ids[i]].second;
+    if constexpr (kHasPayloads) end_payloads[i] = contained_payloads[end_ids[i]];
+  }
+
+  tree.push_back (temp);
+  return tree.size () - 1;
+}
+
+/* Fills in the start keys, ids and payloads of every node. A node's intervals in
+   start order are exactly the ones it owns, taken in the global start
+   order, so one stable pass over that order deals every id out to the
+   next free slot of its node without sorting anything. scratch[id] is
+   used to hold the node owning each id. */
+template <typename Coord, typename Id, typename Payload>
+void
+CenteredIntervalTree<Coord, Id, Payload>::fillStartOrders (const std::vector<Node>& tree,
+                                                           std::vector<Id>& scratch)
+{
+  std::vector<Id> next (tree.size ());
+  for (size_t node = 0; node < tree.size (); node++) {
+    next[node] = tree[node].begin;
+    for (Id i = tree[node].begin; i < tree[node].begin + tree[node].count; i++) {
+      scratch[end_ids[i]] = node;
+    }
+  }
+
+  for (size_t i = 0; i < sorted_start_ids.size (); i++) {
+    Id id = sorted_start_ids[i];
+    Id slot = next[scratch[id]]++;
+    start_ids[slot] = id;
+    start_keys[slot] = sorted_start_keys[i];
+    if constexpr (kHasPayloads) start_payloads[slot] = sorted_start_payloads[i];
+  }
+}
+
+/* Appends a subtree built separately to 'tree', shifting its child
+   indices, and returns the new index of its root */
+template <typename Coord, typename Id, typename Payload>
+Id
+CenteredIntervalTree<Coord, Id, Payload>::appendSubtree (const std::vector<Node>& subtree, Id subtreeRoot,
+                                                         std::vector<Node>& tree)
+{
+  if (subtreeRoot == kNoChild) return kNoChild;
+
+  Id shift = tree.size ();
+  for (size_t i = 0; i < subtree.size (); i++) {
+    Node node = subtree[i];
+    if (node.left != kNoChild) node.left += shift;
+    if (node.right != kNoChild) node.right += shift;
+    tree.push_back (node);
+  }
+  return subtreeRoot + shift;
+}
+
+/* Builds the root node for the subtree holding the ids in
+   end_ids[lo, hi), which are sorted by end point.
+   Takes the median of end values and uses that as the key.
+
+   The range is partitioned in place, keeping end order within each
+   part: intervals ending before the key (already a prefix), then those
+   containing it, then those starting after it. The middle part becomes
+   this node and the outer parts are built recursively. scratch[lo, hi)
+   is the only temporary space used. Nodes are appended to 'tree' in
+   post-order. While spawnDepth is positive the left subtree is built as
+   a separate task into its own node list and spliced in afterwards,
+   which gives exactly the layout of the serial build. */
+template <typename Coord, typename Id, typename Payload>
+Id
+CenteredIntervalTree<Coord, Id, Payload>::buildTree (Id lo, Id hi, std::vector<Id>& scratch,
+                                                     std::vector<Node>& tree, ThreadPool& pool, int spawnDepth)
+{
+  if (lo == hi) {
+    return kNoChild;
+  }
+
+  Id median = lo + (hi - lo)/2;
+  Coord key = contained_intervals[end_ids[median]].second;  // median
+
+  /* Everything before the first end point at or after the key lies
+     entirely to its left */
+  Id split = std::partition_point (end_ids.begin () + lo, end_ids.begin () + median,
+                                   [this, key] (Id id) {
+                                     return contained_intervals[id].second < key;
+                                   }) - end_ids.begin ();
+
+  /* Of the rest, move the intervals starting after the key behind the
+     ones that contain it */
+  Id center_end = split;
+  Id num_right = 0;
+  for (Id i = split; i < hi; i++) {
+    Id id = end_ids[i];
+    if (contained_intervals[id].first > key) scratch[split + num_right++] = id;
+    else end_ids[center_end++] = id;
+  }
+  std::copy (scratch.begin () + split, scratch.begin () + split + num_right,
+             end_ids.begin () + center_end);
+
+  Id left, right;
+  if (spawnDepth > 0) {
+    std::vector<Node> left_tree, right_tree;
+    TaskGroup group (pool);
+    group.run ([&] () {
+      left = buildTree (lo, split, scratch, left_tree, pool, spawnDepth - 1);
+    });
+    right = buildTree (center_end, hi, scratch, right_tree, pool, spawnDepth - 1);
+    group.wait ();
+    left = appendSubtree (left_tree, left, tree);
+    right = appendSubtree (right_tree, right, tree);
+  }
+  else {
+    left = buildTree (lo, split, scratch, tree, pool, 0);
+    right = buildTree (center_end, hi, scratch, tree, pool, 0);
+  }
+  return newNode (key, left, right, split, center_end - split, tree);
+}
+
+/* Copies the nodes built in recursion order into 'nodes' in the requested
+   layout order, rewriting the child indices to match. */
+template <typename Coord, typename Id, typename Payload>
+void
+CenteredIntervalTree<Coord, Id, Payload>::layoutTree (std::vector<Node>& tree, Id treeRoot, Layout layout)
+{
+  if (treeRoot == kNoChild) return;
+
+  std::vector<Id> order;
+  order.reserve (tree.size ());
+  if (layout == kVanEmdeBoas) {
+    layoutVanEmdeBoas (tree, treeRoot, subtreeHeight (tree, treeRoot), order);
+  }
+  else {
+    order.push_back (treeRoot);
+    for (size_t i = 0; i < order.size (); i++) {
+      if (tree[order[i]].left != kNoChild) order.push_back (tree[order[i]].left);
+      if (tree[order[i]].right != kNoChild) order.push_back (tree[order[i]].right);
+    }
+  }
+
+  std::vector<Id> position (tree.size ());
+  for (size_t i = 0; i < order.size (); i++) {
+    position[order[i]] = i;
+  }
+
+  nodes.resize (order.size ());
+  for (size_t i = 0; i < order.size (); i++) {
+    nodes[i] = tree[order[i]];
+    if (nodes[i].left != kNoChild) nodes[i].left = position[nodes[i].left];
+    if (nodes[i].right != kNoChild) nodes[i].right = position[nodes[i].right];
+  }
+}
+
+/* Appends the nodes of the subtree rooted at rootNode that lie less than
+   'height' levels below it, in van Emde Boas order: the top half of the
+   levels first, then every subtree hanging off the bottom of that half
+   from left to right, each laid out recursively the same way. */
+template <typename Coord, typename Id, typename Payload>
+void
+CenteredIntervalTree<Coord, Id, Payload>::layoutVanEmdeBoas (const std::vector<Node>& tree, Id rootNode,
+                                                             int height, std::vector<Id>& order)
+{
+  if (rootNode == kNoChild || height <= 0) return;
+  if (height == 1) {
+    order.push_back (rootNode);
+    return;
+  }
+
+  int top = height / 2;
+  layoutVanEmdeBoas (tree, rootNode, top, order);
+
+  std::vector<Id> frontier (1, rootNode);
+  for (int depth = 0; depth < top; depth++) {
+    std::vector<Id> next;
+    for (size_t i = 0; i < frontier.size (); i++) {
+      if (tree[frontier[i]].left != kNoChild) next.push_back (tree[frontier[i]].left);
+      if (tree[frontier[i]].right != kNoChild) next.push_back (tree[frontier[i]].right);
+    }
+    frontier.swap (next);
+  }
+
+  for (size_t i = 0; i < frontier.size (); i++) {
+    layoutVanEmdeBoas (tree, frontier[i], height - top, order);
+  }
+}
+
+template <typename Coord, typename Id, typename Payload>
+int
+CenteredIntervalTree<Coord, Id, Payload>::subtreeHeight (const std::vector<Node>& tree, Id rootNode)
+{
+  if (rootNode == kNoChild) return 0;
+  return 1 + std::max (subtreeHeight (tree, tree[rootNode].left),
+                       subtreeHeight (tree, tree[rootNode].right));
+}
+
+/* Walks down from the root and calls visitSlice (ids, payloads, first,
+   last) for every run of intervals that contain the point, where the
+   run is [first, last) of the parallel id and payload arrays 'ids' and
+   'payloads'. Each node is touched once and contributes at most one
+   run. */
+template <typename Coord, typename Id, typename Payload>
+template <typename F>
+void
+CenteredIntervalTree<Coord, Id, Payload>::forEachSlice (Coord point, F&& visitSlice) const
+{
+  Id current = nodes.empty () ? kNoChild : 0;
+  while (current != kNoChild) {
+    const Node& node = nodes[current];
+    const Id begin = node.begin;
+
+    /* All the intervals at this level include the point,
+       by construction */
+    if (point == node.key) {
+      visitSlice (end_ids.data (), end_payloads.data (), begin, begin + node.count);
+      return;
+    }
+
+    /* Case when should go through start points until
+       reach start point more than point, report all intervals
+       in this node with start points at most point and then
+       go search left node */
+    if (point < node.key) {
+      size_t cut = countLeadingAtMost (&start_keys[begin], node.count, point);
+      visitSlice (start_ids.data (), start_payloads.data (), begin, begin + cut);
+      current = node.left;
+    }
+
+    /* Case when should go through end points until
+       reach end point less than point, report all intervals
+       in this node with end points at least point and
+       then go search right node */
+    else {
+      size_t cut = countTrailingAtLeast (&end_keys[begin], node.count, point);
+      visitSlice (end_ids.data (), end_payloads.data (), begin + node.count - cut,
+                  begin + node.count);
+      current = node.right;
+    }
+  }
+}
+
+/* The intervals overlapping [start, end] are those containing start,
+   plus those starting inside (start, end]. The two groups are disjoint,
+   so every interval is reported exactly once: the first group comes from
+   a point query at start and the second is one contiguous run of the
+   global start order. */
+template <typename Coord, typename Id, typename Payload>
+template <typename F>
+void
+CenteredIntervalTree<Coord, Id, Payload>::forEachSlice (std::pair<Coord, Coord> interval,
+                                                        F&& visitSlice) const
+{
+  if (interval.first > interval.second) return;
+
+  forEachSlice (interval.first, visitSlice);
+
+  size_t first = branchlessUpperBound (sorted_start_keys.data (), sorted_start_keys.size (),
+                                       interval.first);
+  size_t last = first + branchlessUpperBound (sorted_start_keys.data () + first,
+                                              sorted_start_keys.size () - first, interval.second);
+  visitSlice (sorted_start_ids.data (), sorted_start_payloads.data (), first, last);
+}
+
+/* Calls visitRun (first, last) for every run of ids found by forEachSlice */
+template <typename Coord, typename Id, typename Payload>
+template <typename F>
+void
+CenteredIntervalTree<Coord, Id, Payload>::forEachRun (Coord point, F&& visitRun) const
+{
+  forEachSlice (point, [&visitRun] (const Id* ids, const Payload*, size_t first, size_t last) {
+    visitRun (ids + first, ids + last);
+  });
+}
+
+template <typename Coord, typename Id, typename Payload>
+template <typename F>
+void
+CenteredIntervalTree<Coord, Id, Payload>::forEachRun (std::pair<Coord, Coord> interval,
+                                                      F&& visitRun) const
+{
+  forEachSlice (interval, [&visitRun] (const Id* ids, const Payload*, size_t first, size_t last) {
+    visitRun (ids + first, ids + last);
+  });
+}
+
+template <typename Coord, typename Id, typename Payload>
+template <typename F>
+void
+CenteredIntervalTree<Coord, Id, Payload>::forEachOverlap (Coord point, F&& visit) const
+{
+  forEachRun (point, [&visit] (const Id* first, const Id* last) {
+    for (; first != last; ++first) visit (*first);
+  });
+}
+
+template <typename Coord, typename Id, typename Payload>
+template <typename F>
+void
+CenteredIntervalTree<Coord, Id, Payload>::forEachOverlap (std::pair<Coord, Coord> interval, F&& visit) const
+{
+  forEachRun (interval, [&visit] (const Id* first, const Id* last) {
+    for (; first != last; ++first) visit (*first);
+  });
+}
+
+template <typename Coord, typename Id, typename Payload>
+template <typename F>
+void
+CenteredIntervalTree<Coord, Id, Payload>::forEachPayload (Coord point, F&& visit) const
+{
+  static_assert (kHasPayloads, "This tree stores no payloads");
+  forEachSlice (point, [&visit] (const Id*, const Payload* payloads, size_t first, size_t last) {
+    for (; first != last; ++first) visit (payloads[first]);
+  });
+}
+
+template <typename Coord, typename Id, typename Payload>
+template <typename F>
+void
+CenteredIntervalTree<Coord, Id, Payload>::forEachPayload (std::pair<Coord, Coord> interval,
+                                                          F&& visit) const
+{
+  static_assert (kHasPayloads, "This tree stores no payloads");
+  forEachSlice (interval, [&visit] (const Id*, const Payload* payloads, size_t first, size_t last) {
+    for (; first != last; ++first) visit (payloads[first]);
+  });
+}
+
+/* Helper function for performing a point query */
+template <typename Coord, typename Id, typename Payload>
+void
+CenteredIntervalTree<Coord, Id, Payload>::pointSearchHelper (Coord point, std::unordered_set<Id>& intervals) const
+{
+  forEachRun (point, [&intervals] (const Id* first, const Id* last) {
+    intervals.insert (first, last);
+  });
+}
+
+template <typename Coord, typename Id, typename Payload>
+std::unordered_set<Id>
+CenteredIntervalTree<Coord, Id, Payload>::pointSearch (Coord point) const
+{
+  std::unordered_set<Id> intervals;
+  pointSearchHelper (point, intervals);
+  return intervals;
+}
+
+template <typename Coord, typename Id, typename Payload>
+void
+CenteredIntervalTree<Coord, Id, Payload>::pointSearch (Coord point, std::vector<Id>& results) const
+{
+  forEachRun (point, [&results] (const Id* first, const Id* last) {
+    results.insert (results.end (), first, last);
+  });
+}
+
+template <typename Coord, typename Id, typename Payload>
+std::unordered_set<Id>
+CenteredIntervalTree<Coord, Id, Payload>::intervalSearch (std::pair<Coord, Coord> interval) const
+{
+  std::unordered_set<Id> overlaps;
+  forEachRun (interval, [&overlaps] (const Id* first, const Id* last) {
+    overlaps.insert (first, last);
+  });
+  return overlaps;
+}
+
+template <typename Coord, typename Id, typename Payload>
+void
+CenteredIntervalTree<Coord, Id, Payload>::intervalSearch (std::pair<Coord, Coord> interval,
+                                                          std::vector<Id>& results) const
+{
+  forEachRun (interval, [&results] (const Id* first, const Id* last) {
+    results.insert (results.end (), first, last);
+  });
+}
+
+/* Calls visitRun (probe, first, last) for every run of ids matching one
+   of the sorted probes[0, count) within the subtree at rootNode. Along a
+   node's start keys the cut position only moves forward as the probes
+   grow, and likewise along its end keys, so each node costs one pass
+   over its endpoints plus one step per probe. */
+template <typename Coord, typename Id, typename Payload>
+template <typename F>
+void
+CenteredIntervalTree<Coord, Id, Payload>::forEachBatchRun (Id rootNode, const std::pair<Coord, size_t>* probes,
+                                                           size_t count, F& visitRun) const
+{
+  if (rootNode == kNoChild || count == 0) return;
+
+  const Node& node = nodes[rootNode];
+  const Id begin = node.begin;
+  const Coord key = node.key;
+
+  /* Probes below the key take the intervals starting at or before them */
+  size_t lower = 0;
+  Id cut = 0;
+  for (; lower < count && probes[lower].first < key; lower++) {
+    while (cut < node.count && start_keys[begin + cut] <= probes[lower].first) cut++;
+    visitRun (probes[lower].second, &start_ids[begin], &start_ids[begin] + cut);
+  }
+
+  /* Probes equal to the key take every interval at this node */
+  size_t upper = lower;
+  for (; upper < count && probes[upper].first == key; upper++) {
+    visitRun (probes[upper].second, &end_ids[begin], &end_ids[begin] + node.count);
+  }
+
+  /* Probes above the key take the intervals ending at or after them */
+  cut = 0;
+  for (size_t i = upper; i < count; i++) {
+    while (cut < node.count && end_keys[begin + cut] < probes[i].first) cut++;
+    visitRun (probes[i].second, &end_ids[begin] + cut, &end_ids[begin] + node.count);
+  }
+
+  forEachBatchRun (node.left, probes, lower, visitRun);
+  forEachBatchRun (node.right, probes + upper, count - upper, visitRun);
+}
+
+template <typename Coord, typename Id, typename Payload>
+void
+CenteredIntervalTree<Coord, Id, Payload>::pointSearchBatch (const Coord* points, size_t count,
+                                                            BatchResult& results, bool presorted) const
+{
+  results.probes.resize (count);
+  for (size_t i = 0; i < count; i++) {
+    results.probes[i] = std::make_pair (points[i], i);
+  }
+  if (!presorted) {
+    std::sort (results.probes.begin (), results.probes.end ());
+  }
+
+  /* First pass counts the matches of every probe, which gives the row
+     offsets; the second pass copies the ids into place */
+  results.offsets.assign (count + 1, 0);
+  auto countRun = [&results] (size_t probe, const Id* first, const Id* last) {
+    results.offsets[probe + 1] += last - first;
+  };
+  forEachBatchRun (nodes.empty () ? kNoChild : 0, results.probes.data (), count, countRun);
+  for (size_t i = 0; i < count; i++) {
+    results.offsets[i + 1] += results.offsets[i];
+  }
+
+  /* The offsets are used as write cursors and shifted back afterwards */
+  results.ids.resize (results.offsets[count]);
+  auto copyRun = [&results] (size_t probe, const Id* first, const Id* last) {
+    results.offsets[probe] = std::copy (first, last, results.ids.begin () + results.offsets[probe])
+                             - results.ids.begin ();
+  };
+  forEachBatchRun (nodes.empty () ? kNoChild : 0, results.probes.data (), count, copyRun);
+  for (size_t i = count; i > 0; i--) {
+    results.offsets[i] = results.offsets[i - 1];
+  }
+  results.offsets[0] = 0;
+}
+
+template <typename Coord, typename Id, typename Payload>
+void
+CenteredIntervalTree<Coord, Id, Payload>::pointSearchBatch (const std::vector<Coord>& points,
+                                                            BatchResult& results, bool presorted) const
+{
+  pointSearchBatch (points.data (), points.size (), results, presorted);
+}
+
+/* An interval contains the point iff it starts at or before it and does
+   not end before it. Every interval ending before the point also starts
+   before it, so the count is (# starts <= point) - (# ends < point). */
+template <typename Coord, typename Id, typename Payload>
+Id
+CenteredIntervalTree<Coord, Id, Payload>::pointCount (Coord point) const
+{
+  return intervalCount (std::make_pair (point, point));
+}
+
+/* Likewise an interval overlaps [start, end] iff it starts at or before
+   end and does not end before start */
+template <typename Coord, typename Id, typename Payload>
+Id
+CenteredIntervalTree<Coord, Id, Payload>::intervalCount (std::pair<Coord, Coord> interval) const
+{
+  if (interval.first > interval.second) return 0;
+  Id starts = branchlessUpperBound (sorted_start_keys.data (), sorted_start_keys.size (),
+                                    interval.second);
+  Id ends = branchlessLowerBound (sorted_end_keys.data (), sorted_end_keys.size (),
+                                  interval.first);
+  return starts - ends;
+}
+
+/* Returns the intervals corresponding to the indices provided by
+   the unordered set 'overlaps'. */
+template <typename Coord, typename Id, typename Payload>
+std::vector<std::pair<Coord, Coord> >
+CenteredIntervalTree<Coord, Id, Payload>::returnIntervals (const std::unordered_set<Id>& overlaps) const
+{
+  std::vector<std::pair<Coord, Coord> > intervals;
+  for (const Id& index: overlaps) {
+    intervals.push_back (contained_intervals[index]);
+  }
+
+  return intervals;
+}
+
+template <typename Coord, typename Id, typename Payload>
+typename CenteredIntervalTree<Coord, Id, Payload>::IntervalView
+CenteredIntervalTree<Coord, Id, Payload>::returnIntervals (const std::vector<Id>& overlaps) const
+{
+  return IntervalView (contained_intervals.data (), overlaps);
+}
+
+template <typename Coord, typename Id, typename Payload>
+void
+CenteredIntervalTree<Coord, Id, Payload>::printTree (void) const
+{
+  if (nodes.empty ()) return;
+  traverse (0);
+}
+
+template <typename Coord, typename Id, typename Payload>
+void
+CenteredIntervalTree<Coord, Id, Payload>::traverse (Id rootNode) const
+{
+  if (rootNode == kNoChild) {
+    return;
+  }
+
+  const Node& node = nodes[rootNode];
+  traverse (node.left);
+  std::cout << node.key << std::endl;
+  std::vector<std::tuple<Coord, Coord, Id> > sorted_ends;
+  for (Id i = node.begin; i < node.begin + node.count; i++) {
+    sorted_ends.push_back (std::make_tuple (contained_intervals[end_ids[i]].first,
+                                            end_keys[i], end_ids[i]));
+  }
+  printTupleVec (sorted_ends);
+  traverse (node.right);
+}
+
+template <typename Coord, typename Id, typename Payload>
+void
+CenteredIntervalTree<Coord, Id, Payload>::printTupleVec (const std::vector<std::tuple<Coord, Coord, Id> >& vec) const
+{
+  std::cout << "---Printing Vector---" << std::endl;
+  for (size_t i = 0; i < vec.size (); i++) {
+    std::cout << std::get<0> (vec[i]) << " " << std::get<1> (vec[i])
+              << " " << std::get<2> (vec[i]) << std::endl;
+  }
+  std::cout << std::endl;
+}
+
+template <typename Coord, typename Id, typename Payload>
+void
+CenteredIntervalTree<Coord, Id, Payload>::printPairVec (const std::vector<std::pair<Coord, Coord> >& vec) const
+{
+  std::cout << "---Printing Vector---" << std::endl;
+  for (size_t i = 0; i < vec.size (); i++) {
+    std::cout << vec[i].first << " " << vec[i].second << std::endl;
+  }
+  std::cout << std::endl;
+}
+
+template <typename Coord, typename Id, typename Payload>
+std::vector<std::pair<Coord, Coord> >
+CenteredIntervalTree<Coord, Id, Payload>::getStoredIntervalsCopy (void) const
+{
+  return std::vector<std::pair<Coord, Coord> > (contained_intervals.begin (),
+                                                contained_intervals.end ());
+}
+
 #endif
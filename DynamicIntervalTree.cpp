@@ -1,66 +1,67 @@
 #include "DynamicIntervalTree.h"
-#include <stack>
-#include <unordered_set>
+#include "EpochVisited.h"
 #include <functional>
 #include <algorithm>
+#include <limits>
 
 using namespace std;
 
-struct Hash {
-  size_t operator()(const DynamicIntervalTree::Interval &interval) const {
-    return interval.start;
-  }
-};
-
 inline bool operator== (DynamicIntervalTree::Interval const& lhs, DynamicIntervalTree::Interval const& rhs)
 {
   return (lhs.start == rhs.start) &&
          (lhs.end == rhs.end);
 }
 
-DynamicIntervalTree::DynamicIntervalTree() {
+/* Keys of an entry in the ascending and descending lists of a node */
+static inline DynamicIntervalTree::ListKey startKey(const DynamicIntervalTree::Entry &entry) {
+  return DynamicIntervalTree::StartKey()(entry);
+}
+
+static inline DynamicIntervalTree::ListKey endKey(const DynamicIntervalTree::Entry &entry) {
+  return DynamicIntervalTree::EndKey()(entry);
+}
+
+DynamicIntervalTree::DynamicIntervalTree()
+  : combined_points(PoolAllocator<Endpoint>(&pool)),
+    start_points(PoolAllocator<double>(&pool)),
+    end_points(PoolAllocator<double>(&pool)),
+    delete_path(PoolAllocator<Node *>(&pool)) {
   root = NULL;
+  num_ids = 0;
 }
 
+/*
+  Every node, list chunk and end point index node is in the pool, which
+  frees all of its memory at once, so nothing is visited one by one. The
+  indexes are emptied first so their destructors don't walk their nodes.
+*/
 DynamicIntervalTree::~DynamicIntervalTree() {
-  while (root != nullptr) {
-    /* If root has no left subtree, just delete root. */
-    if (root->left == nullptr) {
-      Node* next = root->right;
-      delete root;
-      root = next;
-    }
-    /* Otherwise, root has left subtree. Do right rotation to move
-       that child to the left. */
-    else {
-      Node* child = root->left;
-      root->left = child->right;
-      child->right = root;
-      root = child;
-    }
-  }
+  combined_points.abandon();
+  start_points.abandon();
+  end_points.abandon();
 }
 
 /*
   Helper Function: newNode
   ========================
-  Create a new node given the interval.
+  Create a new node given the interval, in the pool.
 */
 DynamicIntervalTree::Node *
-DynamicIntervalTree::newNode(Interval interval) {
-  Skiplist<double, Interval> ascendingList;
-  ReverseSkiplist<double, Interval> descendingList;
-  ascendingList.insert (interval.start, interval);
-  descendingList.insert (interval.end, interval);
-  Node *temp = new Node;
-  temp->center = (interval.start + interval.end)/2;
+DynamicIntervalTree::newNode(Entry entry) {
+  Node *temp = new (pool.allocate(sizeof(Node))) Node(ListAllocator(&pool));
+  temp->center = (entry.interval.start + entry.interval.end)/2;
   temp->left = temp->right = NULL;
-  temp->ascending = ascendingList;
-  temp->descending = descendingList;
+  temp->ascending.insert (entry);
+  temp->descending.insert (entry);
   temp->height = 1;
   return temp;
 }
 
+void DynamicIntervalTree::freeNode(Node *node) {
+  node->~Node();
+  pool.deallocate(node, sizeof(Node));
+}
+
 int DynamicIntervalTree::height(Node* node) {
   if (node == NULL) return 0;
   return node->height;
@@ -131,31 +132,29 @@ DynamicIntervalTree::leftRotate(Node *x) {
 DynamicIntervalTree:: Node*
 DynamicIntervalTree::assimilateOverlappingIntervals(Node *from, Node *to) {
 
-  // Get overlapped elements
-  vector<Interval> tmp;
+  // Move the overlapped elements from 'from' to 'to'. They are a run
+  // at the front of one of the lists of 'from', so they are taken off
+  // one by one from there and nothing has to be gathered first.
   if (to->center < from->center) {
-    for (Skiplist<double, Interval>::iterator itr = from->ascending.begin();
-         itr != from->ascending.end(); ++itr) {
-      if (itr->second.start > to->center) break;
-      tmp.push_back (itr->second);
+    while (!from->ascending.empty()) {
+      Entry entry = *from->ascending.begin();
+      if (entry.interval.start > to->center) break;
+      from->ascending.erase(startKey(entry));
+      from->descending.erase(endKey(entry));
+      to->ascending.insert(entry);
+      to->descending.insert(entry);
     }
   } else {
-    for (ReverseSkiplist<double, Interval>::iterator itr = from->descending.begin();
-         itr != from->descending.end(); ++itr) {
-      if (itr->second.end < to->center) break;
-      tmp.push_back(itr->second);
+    while (!from->descending.empty()) {
+      Entry entry = *from->descending.begin();
+      if (entry.interval.end < to->center) break;
+      from->ascending.erase(startKey(entry));
+      from->descending.erase(endKey(entry));
+      to->ascending.insert(entry);
+      to->descending.insert(entry);
     }
   }
 
-  // Remove elements from ascending and descending from 'from' and
-  // Add them to 'to'
-  for (int i = 0; i < tmp.size(); i++) {
-    from->ascending.erase(tmp[i].start);
-    from->descending.erase(tmp[i].end);
-    to->ascending.insert(tmp[i].start, tmp[i]);
-    to->descending.insert(tmp[i].end, tmp[i]);
-  }
-
   if ((from->ascending).size() == 0) {
     return deleteNode(from);
   }
@@ -168,37 +167,38 @@ DynamicIntervalTree::Node*
 DynamicIntervalTree::deleteNode(Node *node) {
 
   if (node->left == NULL && node->right == NULL) {
-    // free(node);
+    freeNode(node);
     return NULL;
   }
 
   if (node->left == NULL) {
     Node *returnNode = node->right;
-    // free(node);
+    freeNode(node);
     return returnNode;
   }
   else {
     Node *n = node->left;
-    stack<Node *> s;
+    vector<Node *, PoolAllocator<Node *> > &s = delete_path;
+    size_t base = s.size();
 
     while (n->right != NULL) {
-      s.push (n);
+      s.push_back (n);
       n = n->right;
     }
 
-    if (!s.empty()) {
-      s.top()->right = n->left;
+    if (s.size() > base) {
+      s.back()->right = n->left;
       n->left = node->left;
     }
     n->right = node->right;
 
     Node *newRoot = n;
-    while (!s.empty()) {
-      n = s.top();
-      s.pop();
-      if (!s.empty()) {
-        s.top()->right = assimilateOverlappingIntervals(n, newRoot);
-        s.top()->height = max(height(s.top()->left), height(s.top()->right)) + 1;
+    while (s.size() > base) {
+      n = s.back();
+      s.pop_back();
+      if (s.size() > base) {
+        s.back()->right = assimilateOverlappingIntervals(n, newRoot);
+        s.back()->height = max(height(s.back()->left), height(s.back()->right)) + 1;
       }
       else {
         newRoot->left = assimilateOverlappingIntervals(n, newRoot);
@@ -207,8 +207,7 @@ DynamicIntervalTree::deleteNode(Node *node) {
     }
     newRoot->height = max(height(newRoot->left), height(newRoot->right)) + 1;
 
-    // Need TO FREE NODE
-    // free(node);
+    freeNode(node);
     return balanceOut(newRoot);
   }
 }
@@ -237,91 +236,137 @@ DynamicIntervalTree::balanceOut(Node* node) {
 }
 
 DynamicIntervalTree::Node*
-DynamicIntervalTree::insertIntervalRecurse(Node *node, Interval interval) {
+DynamicIntervalTree::insertIntervalRecurse(Node *node, Entry entry) {
   if (node == NULL) {
-    return newNode(interval);
+    return newNode(entry);
   }
 
+  const Interval &interval = entry.interval;
   if (interval.start <= node->center && node->center <= interval.end) {
-    (node->ascending).insert(interval.start, interval);
-    (node->descending).insert(interval.end, interval);
+    (node->ascending).insert(entry);
+    (node->descending).insert(entry);
     return node;
   } else if (node->center > interval.end) {
-    node->left = insertIntervalRecurse(node->left, interval);
+    node->left = insertIntervalRecurse(node->left, entry);
     node->height = max(height(node->left), height(node->right)) + 1;
   } else {
-    node->right = insertIntervalRecurse(node->right, interval);
+    node->right = insertIntervalRecurse(node->right, entry);
     node->height = max(height(node->left), height(node->right)) + 1;
   }
 
   return balanceOut(node);
 }
 
-void DynamicIntervalTree::insertInterval(Interval interval) {
-  int index = findStartIndex (interval.start, 0, combined_points.size() - 1);
-  combined_points.insert (combined_points.begin () + index, make_pair(interval.start, interval));
-  index = findEndIndex (interval.end, 0, combined_points.size() - 1);
-  combined_points.insert (combined_points.begin() + index + 1, make_pair(interval.end, interval));
+DynamicIntervalTree::Handle DynamicIntervalTree::insertInterval(Interval interval) {
+  Entry entry = {interval, num_ids};
+  if (free_ids.empty()) {
+    num_ids++;
+    id_intervals.push_back(interval);
+    id_used.push_back(true);
+  } else {
+    entry.id = free_ids.back();
+    free_ids.pop_back();
+    id_intervals[entry.id] = interval;
+    id_used[entry.id] = true;
+  }
+
+  Endpoint start = {interval.start, interval, entry.id};
+  Endpoint end = {interval.end, interval, entry.id};
+  combined_points.insert(start);
+  combined_points.insert(end);
+  start_points.insert(interval.start);
+  end_points.insert(interval.end);
 
   if (root == NULL) {
-    root = newNode(interval);
-    return;
+    root = newNode(entry);
+    return entry.id;
   }
 
-  insertIntervalRecurse(root, interval);
+  insertIntervalRecurse(root, entry);
+  return entry.id;
+}
+
+void DynamicIntervalTree::reserve(int count) {
+  if (count <= 0) return;
+  id_intervals.reserve(count);
+  id_used.reserve(count);
+  free_ids.reserve(count);
 }
 
+/*
+  Helper Function: removeIntervalRecurse
+  ======================================
+  The interval lives in the first node on its way down whose center it
+  contains, so the descent leads straight to it, and removing it there
+  takes two lookups by (end point, id).
+*/
 DynamicIntervalTree::Node*
-DynamicIntervalTree::removeIntervalRecurse(Node *node, Interval interval) {
+DynamicIntervalTree::removeIntervalRecurse(Node *node, Entry entry) {
   if (node == NULL) return NULL;
+  const Interval &interval = entry.interval;
   if (interval.start <= node->center && node->center <= interval.end) {
-    (node->descending).erase(interval.end);
-    (node->ascending).erase(interval.start);
+    (node->descending).erase(endKey(entry));
+    (node->ascending).erase(startKey(entry));
     if (node->ascending.size() == 0) {
       Node *result = deleteNode(node);
       if (node == root) root = result;
       return result;
     }
   } else if (interval.end < node->center) {
-    node->left = removeIntervalRecurse(node->left, interval);
+    node->left = removeIntervalRecurse(node->left, entry);
   } else {
-    node->right = removeIntervalRecurse(node->right, interval);
+    node->right = removeIntervalRecurse(node->right, entry);
   }
   return balanceOut(node);
 }
 
-void DynamicIntervalTree::removeInterval(Interval interval) {
-  if (root == NULL) return;
+bool DynamicIntervalTree::remove(Handle handle) {
+  if (handle < 0 || handle >= num_ids || !id_used[handle]) return false;
+  Entry entry = {id_intervals[handle], handle};
+  const Interval &interval = entry.interval;
+  id_used[handle] = false;
+  free_ids.push_back(handle);
 
-  // Remove from the array of starts and ends
-  int index = findStartIndex (interval.start, 0, combined_points.size () - 1);
-  combined_points.erase(combined_points.begin() + index);
-  index = findEndIndex (interval.end, 0, combined_points.size () - 1);
-  combined_points.erase(combined_points.begin() + index);
+  Endpoint start = {interval.start, interval, handle};
+  Endpoint end = {interval.end, interval, handle};
+  combined_points.erase(start);
+  combined_points.erase(end);
+  start_points.erase(interval.start);
+  end_points.erase(interval.end);
 
   if (interval.start <= root->center && root->center <= interval.end) {
-    (root->descending).erase(interval.end);
-    (root->ascending).erase(interval.start);
+    (root->descending).erase(endKey(entry));
+    (root->ascending).erase(startKey(entry));
     if (root->ascending.size() == 0) {
       root = deleteNode(root);
     }
   } else {
-    removeIntervalRecurse(root, interval);
+    removeIntervalRecurse(root, entry);
   }
+  return true;
 }
 
-void DynamicIntervalTree::pointQueryRecurse(Node *node, double point, vector<Interval> &result) {
+void DynamicIntervalTree::removeInterval(Interval interval) {
+  // Of several copies of the interval, the one with the lowest id goes
+  Endpoint start = {interval.start, interval, numeric_limits<int>::min()};
+  EndpointIndex::iterator found = combined_points.lowerBound(start);
+  if (found == combined_points.end() || found->key != interval.start ||
+      !(found->interval == interval)) return;
+  remove(found->id);
+}
+
+void DynamicIntervalTree::pointQueryRecurse(Node *node, double point, vector<Entry> &result) {
   if (node == NULL) return;
   if (node->center >= point) {
-    for (Skiplist<double, Interval>::iterator itr = (node->ascending).begin(); itr != (node->ascending).end(); ++itr) {
-      if (itr->first > point) break;
-      result.push_back(itr->second);
+    for (AscendingList::iterator itr = (node->ascending).begin(); itr != (node->ascending).end(); ++itr) {
+      if (itr->interval.start > point) break;
+      result.push_back(*itr);
     }
     pointQueryRecurse(node->left, point, result);
   } else {
-    for (ReverseSkiplist<double, Interval>::iterator itr = (node->descending).begin(); itr != (node->descending).end(); ++itr) {
-      if (itr->first < point) break;
-      result.push_back(itr->second);
+    for (DescendingList::iterator itr = (node->descending).begin(); itr != (node->descending).end(); ++itr) {
+      if (itr->interval.end < point) break;
+      result.push_back(*itr);
     }
     pointQueryRecurse(node->right, point, result);
   }
@@ -330,98 +375,64 @@ void DynamicIntervalTree::pointQueryRecurse(Node *node, double point, vector<Int
 vector<DynamicIntervalTree::Interval> DynamicIntervalTree::pointQuery(double point) {
   vector<Interval> result;
   if (root == NULL) return result;
-  pointQueryRecurse(root, point, result);
-  return result;
-}
-
-/* Looks for the index of the first element in a sorted array that is
-   greater than or equal to start point */
-int
-DynamicIntervalTree::findStartIndex (double start, int left, int right)
-{
-  if (right > left) {
-    int mid = left + (right - left)/2;
-    int next = mid + 1;
-
-    /* Go as far back as possible to reach first occurrence
-       of element similar to start point */
-    while (start == combined_points[mid].first) {
-      mid -= 1;
-      next -= 1;
-    }
-
-    // if (next >= combined_points.size()) return left;
-
-    if (start >= combined_points[mid].first && start <= combined_points[next].first) {
-      return next;
-    }
-    if (start < combined_points[mid].first) {
-      return findStartIndex (start, left, mid);
-    }
-    if (start > combined_points[next].first) {
-      return findStartIndex (start, next, right);
-    }
+  vector<Entry> entries;
+  pointQueryRecurse(root, point, entries);
+  for (size_t i = 0; i < entries.size(); i++) {
+    result.push_back(entries[i].interval);
   }
-
-  return left;
-}
-
-/* Looks for the index of the last element of a sorted array
-   that is less than or equal to end point */
-int
-DynamicIntervalTree::findEndIndex (double end, int left, int right)
-{
-  if (right > left) {
-    int mid = left + (right - left)/2;
-    int next = mid + 1;
-
-    while (end == combined_points[next].first) {
-      next += 1;
-      mid += 1;
-    }
-
-    // if (next >= combined_points.size()) return left;
-
-    if (end >= combined_points[mid].first && end <= combined_points[next].first) {
-      return mid;
-    }
-    if (end < combined_points[mid].first) {
-      return findEndIndex (end, left, mid);
-    }
-    if (end > combined_points[next].first) {
-      return findEndIndex (end, next, right);
-    }
-  }
-
-  return right;
+  return result;
 }
 
+/*
+  An interval overlapping the query either has an end point inside it or
+  contains its midpoint. Intervals found both ways, and those with both
+  end points inside, are reported once by marking their ids in a visited
+  array kept per thread, instead of hashing every candidate.
+*/
 vector<DynamicIntervalTree::Interval> DynamicIntervalTree::intervalQuery(Interval interval) {
-  unordered_set<Interval, Hash> no_duplicates;
-  vector<Interval> vec, result;
-  int q_start = findStartIndex (interval.start, 0, combined_points.size () - 1);
-  if (q_start == combined_points.size ()) return result;  // no intervals can contain this point
-  int q_end = findEndIndex (interval.end, 0, combined_points.size () - 1);
-  if (q_end == -1) return result;
+  static thread_local EpochVisited visited;
+  vector<Entry> vec;
+  vector<Interval> result;
+  if (interval.start > interval.end) return result;
+
+  // Points inside the interval run from the first one not before its start
+  const double lowest = -numeric_limits<double>::infinity();
+  Endpoint first = {interval.start, {lowest, lowest}, numeric_limits<int>::min()};
+  EndpointIndex::iterator itr = combined_points.lowerBound(first);
+  if (itr == combined_points.end()) return result;  // no intervals can contain this point
 
   double query_point = (interval.start + interval.end) / 2;
   pointQueryRecurse (root, query_point, vec);
 
-  for (int i=q_start; i <= q_end; i++) {
-    no_duplicates.insert (combined_points[i].second);
+  visited.reset (num_ids);
+  for (; itr != combined_points.end() && itr->key <= interval.end; ++itr) {
+    if (visited.insert (itr->id)) result.push_back (itr->interval);
   }
 
-  for (int i = 0; i < vec.size(); i++) {
-    no_duplicates.insert (vec[i]);
-  }
-
-  for (const Interval& i: no_duplicates) {
-    result.push_back(i);
+  for (size_t i = 0; i < vec.size(); i++) {
+    if (visited.insert (vec[i].id)) result.push_back (vec[i].interval);
   }
 
   return result;
 }
 
+/*
+  An interval contains the point iff it starts at or before the point and
+  does not end before it, and every interval ending before the point also
+  starts before it. So the count is (# starts <= point) - (# ends < point).
+*/
+int DynamicIntervalTree::pointCount(double point) const {
+  Interval interval = {point, point};
+  return intervalCount(interval);
+}
+
+int DynamicIntervalTree::intervalCount(Interval interval) const {
+  if (interval.start > interval.end) return 0;
+  int starts = start_points.countLessOrEqual(interval.end);
+  int ends = end_points.countLess(interval.start);
+  return starts - ends;
+}
+
 void DynamicIntervalTree::preOrderRecurse(Node *node) {
   if (node == NULL) {
     return;
@@ -430,16 +441,16 @@ void DynamicIntervalTree::preOrderRecurse(Node *node) {
   cout << "=== Node ===" << endl;
   cout << "node height = " << node->height << endl;
   cout << "node center = " << node->center << endl;
-  cout << "node ascending skiplist = ";
+  cout << "node ascending list = ";
 
-  for (Skiplist<double, Interval>::iterator itr = (node->ascending).begin(); itr != (node->ascending).end(); ++itr) {
-    cout << "( " << itr->second.start << "," << itr->second.end << ") ->";
+  for (AscendingList::iterator itr = (node->ascending).begin(); itr != (node->ascending).end(); ++itr) {
+    cout << "( " << itr->interval.start << "," << itr->interval.end << ") ->";
   }
   cout << endl;
 
-  cout << "node descending skiplist = ";
-  for (ReverseSkiplist<double, Interval>::iterator itr = (node->descending).begin(); itr != (node->descending).end(); ++itr) {
-    cout << "( " << itr->second.start << "," << itr->second.end << ") ->";
+  cout << "node descending list = ";
+  for (DescendingList::iterator itr = (node->descending).begin(); itr != (node->descending).end(); ++itr) {
+    cout << "( " << itr->interval.start << "," << itr->interval.end << ") ->";
   }
   cout << "END" << endl;
 
@@ -454,6 +465,6 @@ void DynamicIntervalTree::preOrder() {
   preOrderRecurse(root);
 }
 
-vector<pair<double, DynamicIntervalTree::Interval> > DynamicIntervalTree::getArray() {
+const DynamicIntervalTree::EndpointIndex &DynamicIntervalTree::getArray() const {
   return combined_points;
 }
@@ -1,9 +1,11 @@
 #ifndef Dynamic_Interval_Tree_Included
 #define Dynamic_Interval_Tree_Included
 
-#include "Skiplist.h"
-#include "ReverseSkiplist.h"
+#include "SortedChunkArray.h"
+#include "OrderStatisticTree.h"
+#include "NodePool.h"
 #include <algorithm>
+#include <functional>
 #include <iostream>
 #include <vector>
 
@@ -16,10 +18,61 @@ class DynamicIntervalTree {
       double start, end;
     };
 
+    /* An interval as stored in the tree, with the id it was given when
+       it was inserted */
+    struct Entry {
+      Interval interval;
+      int id;
+    };
+
+    /* Handed out for every inserted interval, and valid until that
+       interval is removed. A handle may then be handed out again. */
+    typedef int Handle;
+
+    /* The intervals containing a node's center, by ascending start and
+       by descending end. Keys pair each end point with the interval's
+       id, so intervals sharing an end point, or equal intervals, are
+       all kept. The lists hold only the entries and read the keys out
+       of them. */
+    typedef pair<double, int> ListKey;
+    struct StartKey {
+      ListKey operator() (const Entry &entry) const { return ListKey(entry.interval.start, entry.id); }
+    };
+    struct EndKey {
+      ListKey operator() (const Entry &entry) const { return ListKey(entry.interval.end, entry.id); }
+    };
+    typedef PoolAllocator<Entry> ListAllocator;
+    typedef SortedChunkArray<ListKey, Entry, StartKey, less<ListKey>, ListAllocator> AscendingList;
+    typedef SortedChunkArray<ListKey, Entry, EndKey, greater<ListKey>, ListAllocator> DescendingList;
+
+    /* A start or end point of an interval, as kept in the ordered index
+       of all end points */
+    struct Endpoint {
+      double key;
+      Interval interval;
+      int id;
+    };
+
+    /* Orders end points by key, then by the start, end and id of their
+       interval */
+    struct EndpointOrder {
+      bool operator() (const Endpoint& a, const Endpoint& b) const {
+        if (a.key != b.key) return a.key < b.key;
+        if (a.interval.start != b.interval.start) return a.interval.start < b.interval.start;
+        if (a.interval.end != b.interval.end) return a.interval.end < b.interval.end;
+        return a.id < b.id;
+      }
+    };
+
+    typedef OrderStatisticTree<Endpoint, EndpointOrder, PoolAllocator<Endpoint> > EndpointIndex;
+    typedef OrderStatisticTree<double, less<double>, PoolAllocator<double> > PointIndex;
+
     struct Node {
+      Node(const ListAllocator &allocator) : ascending(allocator), descending(allocator) {}
+
       double center;
-      Skiplist<double, Interval> ascending;
-      ReverseSkiplist<double, Interval> descending;
+      AscendingList ascending;
+      DescendingList descending;
       Node *left, *right;
       int height;
     };
@@ -32,22 +85,66 @@ class DynamicIntervalTree {
 
     vector<Interval> intervalQuery(Interval interval);
 
-    void insertInterval(Interval interval);
+    /* Number of intervals containing the point, from rank queries on the
+       sorted start and end points */
+    int pointCount(double point) const;
+
+    /* Number of intervals overlapping the interval */
+    int intervalCount(Interval interval) const;
 
+    /* Adds the interval, even if an equal one is already stored, and
+       returns its handle */
+    Handle insertInterval(Interval interval);
+
+    /* Removes the interval with this handle, going down the tree along
+       its stored end points. Returns false if no interval has it. */
+    bool remove(Handle handle);
+
+    /* Makes room in the id table for this many stored intervals, so
+       that it does not grow while they are inserted */
+    void reserve(int count);
+
+    /* Removes one interval equal to this one, if any is stored */
     void removeInterval(Interval interval);
 
     void preOrder();
 
-    vector<std::pair<double, Interval> > getArray(void);
+    /* Every start and end point in order, as a read-only view */
+    const EndpointIndex &getArray(void) const;
 
   private:
 
+    /* Nodes, their lists, the end point indexes and the scratch vector
+       all live here, and go with it when the tree is destroyed. It comes
+       first so that it is destroyed last. The id vectors use the
+       ordinary heap, so that their old buffers are given back as they
+       grow; they only grow when more intervals are stored than ever
+       before, as ids are handed out again. */
+    NodePool pool;
+
     Node *root;
-    vector<std::pair<double, Interval> > combined_points;
-    vector<Interval> startIntervals;
-    vector<Interval> endIntervals;
 
-    Node *newNode(Interval interval);
+    /* Every start and end point in EndpointOrder */
+    EndpointIndex combined_points;
+    PointIndex start_points;
+    PointIndex end_points;
+
+    /* The interval with each id, and whether the id is in use. Ids are
+       the handles. Ids of removed intervals are handed out again before
+       new ones. */
+    vector<Interval> id_intervals;
+    vector<bool> id_used;
+    vector<int> free_ids;
+    int num_ids;                  // ids handed out so far
+
+    /* Scratch space kept between updates, so that a tree of steady size
+       does not allocate. deleteNode may run inside another deleteNode,
+       and each call only pops what it pushed onto delete_path. */
+    vector<Node *, PoolAllocator<Node *> > delete_path;
+
+    Node *newNode(Entry entry);
+
+    void freeNode(Node *node);
 
     int height(Node *node);
 
@@ -61,18 +158,14 @@ class DynamicIntervalTree {
 
     Node *balanceOut (Node *node);
 
-    Node *insertIntervalRecurse(Node *node, Interval interval);
+    Node *insertIntervalRecurse(Node *node, Entry entry);
 
-    Node *removeIntervalRecurse(Node *node, Interval interval);
+    Node *removeIntervalRecurse(Node *node, Entry entry);
 
-    void pointQueryRecurse(Node *node, double point, vector<Interval> &result);
+    void pointQueryRecurse(Node *node, double point, vector<Entry> &result);
 
     void preOrderRecurse(Node *node);
 
-    int findStartIndex(double start, int left, int right);
-
-    int findEndIndex(double end, int left, int right);
-
 };
 
 #endif
@@ -0,0 +1,134 @@
+#include "EndpointScan.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define ENDPOINT_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+  typedef size_t (*ScanKernel) (const double*, size_t, double);
+
+  struct KernelSet {
+    ScanKernel leading;
+    ScanKernel trailing;
+    const char* name;
+  };
+
+  size_t
+  countLeadingAtMostScalar (const double* keys, size_t count, double point)
+  {
+    size_t i = 0;
+    while (i < count && keys[i] <= point) i++;
+    return i;
+  }
+
+  size_t
+  countTrailingAtLeastScalar (const double* keys, size_t count, double point)
+  {
+    size_t i = count;
+    while (i > 0 && keys[i - 1] >= point) i--;
+    return count - i;
+  }
+
+#ifdef ENDPOINT_SCAN_X86
+  /* Each vector kernel compares a block of keys at once and stops at the
+     first block whose comparison mask is not all ones; the position of the
+     first failing lane inside that block gives the cut. */
+
+  __attribute__ ((target ("sse2"))) size_t
+  countLeadingAtMostSse2 (const double* keys, size_t count, double point)
+  {
+    const __m128d p = _mm_set1_pd (point);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+      int mask = _mm_movemask_pd (_mm_cmple_pd (_mm_loadu_pd (keys + i), p));
+      if (mask != 0x3) return i + (mask & 1);
+    }
+    return i + countLeadingAtMostScalar (keys + i, count - i, point);
+  }
+
+  __attribute__ ((target ("sse2"))) size_t
+  countTrailingAtLeastSse2 (const double* keys, size_t count, double point)
+  {
+    const __m128d p = _mm_set1_pd (point);
+    size_t i = count;
+    for (; i >= 2; i -= 2) {
+      int mask = _mm_movemask_pd (_mm_cmpge_pd (_mm_loadu_pd (keys + i - 2), p));
+      if (mask != 0x3) return count - i + (mask >> 1);
+    }
+    return count - i + countTrailingAtLeastScalar (keys, i, point);
+  }
+
+  __attribute__ ((target ("avx2"))) size_t
+  countLeadingAtMostAvx2 (const double* keys, size_t count, double point)
+  {
+    const __m256d p = _mm256_set1_pd (point);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+      __m256d cmp = _mm256_cmp_pd (_mm256_loadu_pd (keys + i), p, _CMP_LE_OQ);
+      int mask = _mm256_movemask_pd (cmp);
+      if (mask != 0xF) return i + __builtin_ctz (~mask);
+    }
+    return i + countLeadingAtMostScalar (keys + i, count - i, point);
+  }
+
+  __attribute__ ((target ("avx2"))) size_t
+  countTrailingAtLeastAvx2 (const double* keys, size_t count, double point)
+  {
+    const __m256d p = _mm256_set1_pd (point);
+    size_t i = count;
+    for (; i >= 4; i -= 4) {
+      __m256d cmp = _mm256_cmp_pd (_mm256_loadu_pd (keys + i - 4), p, _CMP_GE_OQ);
+      int mask = _mm256_movemask_pd (cmp);
+      /* Lane 3 holds the last key; count the set lanes above the highest
+         clear one */
+      if (mask != 0xF) return count - i + (__builtin_clz ((unsigned) (~mask & 0xF)) - 28);
+    }
+    return count - i + countTrailingAtLeastScalar (keys, i, point);
+  }
+#endif
+
+  KernelSet
+  chooseKernels ()
+  {
+#ifdef ENDPOINT_SCAN_X86
+    __builtin_cpu_init ();
+    if (__builtin_cpu_supports ("avx2")) {
+      KernelSet avx2 = { countLeadingAtMostAvx2, countTrailingAtLeastAvx2, "avx2" };
+      return avx2;
+    }
+    if (__builtin_cpu_supports ("sse2")) {
+      KernelSet sse2 = { countLeadingAtMostSse2, countTrailingAtLeastSse2, "sse2" };
+      return sse2;
+    }
+#endif
+    KernelSet scalar = { countLeadingAtMostScalar, countTrailingAtLeastScalar, "scalar" };
+    return scalar;
+  }
+
+  const KernelSet&
+  kernels ()
+  {
+    static const KernelSet chosen = chooseKernels ();
+    return chosen;
+  }
+}
+
+size_t
+countLeadingAtMost (const double* keys, size_t count, double point)
+{
+  return kernels ().leading (keys, count, point);
+}
+
+size_t
+countTrailingAtLeast (const double* keys, size_t count, double point)
+{
+  return kernels ().trailing (keys, count, point);
+}
+
+const char*
+scanKernelName ()
+{
+  return kernels ().name;
+}
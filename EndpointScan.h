@@ -0,0 +1,41 @@
+#ifndef Endpoint_Scan_Included
+#define Endpoint_Scan_Included
+
+#include <cstddef>
+
+/* Scan kernels over a run of endpoint keys sorted in ascending order.
+   An AVX2, SSE2 or scalar implementation is picked once at runtime
+   depending on what the CPU supports. */
+
+/* Returns the number of leading keys in keys[0, count) that are less than
+   or equal to point */
+size_t countLeadingAtMost (const double* keys, size_t count, double point);
+
+/* Returns the number of trailing keys in keys[0, count) that are greater
+   than or equal to point */
+size_t countTrailingAtLeast (const double* keys, size_t count, double point);
+
+/* Portable versions of the two scans for any other key type, such as
+   integer coordinates */
+template <typename Key>
+inline size_t
+countLeadingAtMost (const Key* keys, size_t count, Key point)
+{
+  size_t i = 0;
+  while (i < count && keys[i] <= point) i++;
+  return i;
+}
+
+template <typename Key>
+inline size_t
+countTrailingAtLeast (const Key* keys, size_t count, Key point)
+{
+  size_t i = count;
+  while (i > 0 && keys[i - 1] >= point) i--;
+  return count - i;
+}
+
+/* Name of the kernel set chosen for this CPU, for reporting */
+const char* scanKernelName ();
+
+#endif
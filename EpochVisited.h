@@ -0,0 +1,46 @@
+#ifndef Epoch_Visited_Included
+#define Epoch_Visited_Included
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>    /* For std::fill */
+
+/* Marks which ids in [0, size) a query has already reported, for
+   deduplicating results without hashing. Every id has a stamp and an id
+   counts as visited when its stamp equals the current epoch, so starting
+   the next query is one increment rather than a pass over the array;
+   the stamps are only cleared when the epoch counter wraps around.
+   Checking a candidate is one load and at most one store.
+
+   Meant to be kept per thread and reused across queries, e.g. as a
+   thread_local. */
+class EpochVisited
+{
+  public:
+    EpochVisited () : epoch (0) {}
+
+    /* Starts a new query over ids in [0, size), with nothing visited */
+    void reset (size_t size)
+    {
+      if (stamps.size () < size) stamps.resize (size, 0);
+      if (++epoch == 0) {
+        std::fill (stamps.begin (), stamps.end (), 0);
+        epoch = 1;
+      }
+    }
+
+    /* Marks id as visited, and returns whether it was not already */
+    bool insert (size_t id)
+    {
+      if (stamps[id] == epoch) return false;
+      stamps[id] = epoch;
+      return true;
+    }
+
+  private:
+    std::vector<uint32_t> stamps;
+    uint32_t epoch;
+};
+
+#endif
@@ -0,0 +1,341 @@
+#ifndef Implicit_Interval_Tree_Included
+#define Implicit_Interval_Tree_Included
+
+#include <vector>
+#include <algorithm>
+#include <unordered_set>
+#include <utility>        /* For std::pair */
+#include <string>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <stdexcept>
+#include "RadixSort.h"
+
+/* Static augmented interval tree stored implicitly in one sorted array,
+   in the manner of cgranges. The intervals are sorted by start point and
+   the array itself is the tree: the node at index i sits at level k,
+   where k is the number of trailing one bits of i, and its children are
+   i - 2^(k-1) and i + 2^(k-1). Every entry also records the greatest end
+   point in its subtree. There are no pointers and no per-node lists; a
+   tree of 32-bit positions takes 12 bytes per interval, and building it
+   is one sort and one pass.
+
+   An interval's id is its index in start order, which is also the order
+   of getStoredIntervalsCopy. Queries report ids in ascending order.
+   Same query interface as CenteredIntervalTree, so the two can be
+   compared with the same driver. */
+template <typename Coord = double, typename Id = int>
+class ImplicitIntervalTree
+{
+  static_assert (std::is_arithmetic<Coord>::value, "Coord must be an arithmetic type");
+  static_assert (std::is_integral<Id>::value, "Id must be an integer type");
+
+  public:
+    typedef Coord coord_type;
+    typedef Id id_type;
+
+    /* Given a list of intervals, constructs a new interval tree holding
+       these elements. Throws std::length_error if there are too many
+       intervals to number with Id. */
+    ImplicitIntervalTree (const std::vector<std::pair<Coord, Coord> >& intervals);
+
+    /* Return all the intervals in the tree that contain the requested point */
+    std::unordered_set<Id> pointSearch (Coord point) const;
+
+    /* Append the intervals that contain the requested point to 'results' */
+    void pointSearch (Coord point, std::vector<Id>& results) const;
+
+    /* Return all the intervals in the tree that overlap the requested interval */
+    std::unordered_set<Id> intervalSearch (std::pair<Coord, Coord> interval) const;
+
+    /* Append the intervals that overlap the requested interval to
+       'results'. An interval whose start is greater than its end
+       overlaps nothing. */
+    void intervalSearch (std::pair<Coord, Coord> interval, std::vector<Id>& results) const;
+
+    /* Call visit (id) for every interval that contains the requested point */
+    template <typename F>
+    void forEachOverlap (Coord point, F&& visit) const;
+
+    /* Call visit (id) for every interval that overlaps the requested interval */
+    template <typename F>
+    void forEachOverlap (std::pair<Coord, Coord> interval, F&& visit) const;
+
+    struct BatchResult;
+
+    /* Answer a point query for each of points[0, count), storing the
+       results in CSR form in 'results' (see BatchResult) */
+    void pointSearchBatch (const Coord* points, size_t count, BatchResult& results) const;
+    void pointSearchBatch (const std::vector<Coord>& points, BatchResult& results) const;
+
+    /* Return the number of intervals that contain the requested point.
+       There are no separate endpoint orders to rank in, so this walks
+       the tree like a query. */
+    Id pointCount (Coord point) const;
+
+    /* Return the number of intervals that overlap the requested interval */
+    Id intervalCount (std::pair<Coord, Coord> interval) const;
+
+    std::vector<std::pair<Coord, Coord> > getStoredIntervalsCopy (void) const;
+
+    static std::string name () {
+      return "Implicit Interval Tree";
+    }
+
+  private:
+    /* One interval, and the greatest end point in the subtree rooted at
+       its index */
+    struct Entry {
+      Coord start;
+      Coord end;
+      Coord max;
+    };
+
+    /* Subtrees of at most 2^(kScanLevel + 1) - 1 entries are scanned
+       linearly rather than descended into */
+    static const int kScanLevel = 3;
+
+    /* A subtree still to visit during a query: its root index and level,
+       and whether its left child has been dealt with already */
+    struct Frame {
+      size_t index;
+      int level;
+      bool left_done;
+    };
+
+    /* Helper Functions */
+    static bool sortByStart (const std::pair<Coord, Coord>& a, const std::pair<Coord, Coord>& b);
+    void computeMaxEnds ();
+
+    /* Entries in start order */
+    std::vector<Entry> entries;
+
+    /* Level of the root, or -1 for an empty tree */
+    int root_level;
+};
+
+/* Results of a batched query in compressed sparse row form: the ids of
+   the intervals matching query i are ids[offsets[i], offsets[i + 1]). */
+template <typename Coord, typename Id>
+struct ImplicitIntervalTree<Coord, Id>::BatchResult
+{
+  std::vector<size_t> offsets;
+  std::vector<Id> ids;
+};
+
+/* * * * * Implementation Below This Point * * * * */
+
+/* Orders intervals by start point, breaking ties by end point */
+template <typename Coord, typename Id>
+bool
+ImplicitIntervalTree<Coord, Id>::sortByStart (const std::pair<Coord, Coord>& a,
+                                              const std::pair<Coord, Coord>& b)
+{
+  if (a.first != b.first) return a.first < b.first;
+  return a.second < b.second;
+}
+
+template <typename Coord, typename Id>
+ImplicitIntervalTree<Coord, Id>::ImplicitIntervalTree (const std::vector<std::pair<Coord, Coord> >& intervals)
+  : root_level (-1)
+{
+  if (intervals.size () > (size_t) std::numeric_limits<Id>::max ()) {
+    throw std::length_error ("Too many intervals for the id type");
+  }
+
+  /* Integer coordinates are radix sorted, by end and then stably by start */
+  std::vector<std::pair<Coord, Coord> > sorted (intervals);
+  if constexpr (std::is_integral<Coord>::value) {
+    radixSort (sorted.data (), sorted.data () + sorted.size (),
+               [] (const std::pair<Coord, Coord>& interval) { return interval.second; });
+    radixSort (sorted.data (), sorted.data () + sorted.size (),
+               [] (const std::pair<Coord, Coord>& interval) { return interval.first; });
+  }
+  else {
+    std::sort (sorted.begin (), sorted.end (), sortByStart);
+  }
+
+  entries.resize (sorted.size ());
+  for (size_t i = 0; i < sorted.size (); i++) {
+    entries[i].start = sorted[i].first;
+    entries[i].end = sorted[i].second;
+  }
+  computeMaxEnds ();
+}
+
+/* Fills in the max end point of every entry, level by level from the
+   leaves up. When the array size is not one less than a power of two,
+   the right child of a node may lie past the end of the array. The part
+   of that subtree that does exist is the tail of the array, so its max
+   is taken from the highest existing ancestor of the last leaf. */
+template <typename Coord, typename Id>
+void
+ImplicitIntervalTree<Coord, Id>::computeMaxEnds ()
+{
+  size_t n = entries.size ();
+  if (n == 0) return;
+
+  /* Leaves are the even indices */
+  size_t last_index = 0;
+  Coord last = Coord ();
+  for (size_t i = 0; i < n; i += 2) {
+    last_index = i;
+    last = entries[i].max = entries[i].end;
+  }
+
+  int level = 1;
+  for (; (size_t (1) << level) <= n; level++) {
+    size_t half = size_t (1) << (level - 1);
+    size_t first = (half << 1) - 1;
+    size_t step = half << 2;
+    for (size_t i = first; i < n; i += step) {
+      Coord left = entries[i - half].max;
+      Coord right = i + half < n ? entries[i + half].max : last;
+      entries[i].max = std::max (entries[i].end, std::max (left, right));
+    }
+
+    /* Move last_index up to its parent at this level */
+    last_index = ((last_index >> level) & 1) ? last_index - half : last_index + half;
+    if (last_index < n && entries[last_index].max > last) {
+      last = entries[last_index].max;
+    }
+  }
+  root_level = level - 1;
+}
+
+/* Walks the implicit tree from the root with an explicit stack, skipping
+   left subtrees whose max end lies before the query and stopping at the
+   first entry that starts after it. Small subtrees are scanned in one
+   pass instead. Ids are visited in ascending order. */
+template <typename Coord, typename Id>
+template <typename F>
+void
+ImplicitIntervalTree<Coord, Id>::forEachOverlap (std::pair<Coord, Coord> interval, F&& visit) const
+{
+  if (root_level < 0 || interval.first > interval.second) return;
+
+  const size_t n = entries.size ();
+  const Coord start = interval.first;
+  const Coord end = interval.second;
+
+  /* The stack holds at most two frames per level */
+  Frame stack[2 * std::numeric_limits<size_t>::digits];
+  int top = 0;
+  stack[top++] = Frame { (size_t (1) << root_level) - 1, root_level, false };
+  while (top > 0) {
+    Frame frame = stack[--top];
+    if (frame.level <= kScanLevel) {
+      size_t first = frame.index >> frame.level << frame.level;
+      size_t last = std::min (n, first + (size_t (1) << (frame.level + 1)) - 1);
+      for (size_t i = first; i < last && entries[i].start <= end; i++) {
+        if (start <= entries[i].end) visit ((Id) i);
+      }
+    }
+    else if (!frame.left_done) {
+      /* Come back for the node itself and its right child after the left
+         child, which may lie past the end of the array */
+      size_t left = frame.index - (size_t (1) << (frame.level - 1));
+      stack[top++] = Frame { frame.index, frame.level, true };
+      if (left >= n || entries[left].max >= start) {
+        stack[top++] = Frame { left, frame.level - 1, false };
+      }
+    }
+    else if (frame.index < n && entries[frame.index].start <= end) {
+      if (start <= entries[frame.index].end) visit ((Id) frame.index);
+      stack[top++] = Frame { frame.index + (size_t (1) << (frame.level - 1)), frame.level - 1, false };
+    }
+  }
+}
+
+template <typename Coord, typename Id>
+template <typename F>
+void
+ImplicitIntervalTree<Coord, Id>::forEachOverlap (Coord point, F&& visit) const
+{
+  forEachOverlap (std::make_pair (point, point), visit);
+}
+
+template <typename Coord, typename Id>
+std::unordered_set<Id>
+ImplicitIntervalTree<Coord, Id>::pointSearch (Coord point) const
+{
+  std::unordered_set<Id> intervals;
+  forEachOverlap (point, [&intervals] (Id id) { intervals.insert (id); });
+  return intervals;
+}
+
+template <typename Coord, typename Id>
+void
+ImplicitIntervalTree<Coord, Id>::pointSearch (Coord point, std::vector<Id>& results) const
+{
+  forEachOverlap (point, [&results] (Id id) { results.push_back (id); });
+}
+
+template <typename Coord, typename Id>
+std::unordered_set<Id>
+ImplicitIntervalTree<Coord, Id>::intervalSearch (std::pair<Coord, Coord> interval) const
+{
+  std::unordered_set<Id> overlaps;
+  forEachOverlap (interval, [&overlaps] (Id id) { overlaps.insert (id); });
+  return overlaps;
+}
+
+template <typename Coord, typename Id>
+void
+ImplicitIntervalTree<Coord, Id>::intervalSearch (std::pair<Coord, Coord> interval,
+                                                 std::vector<Id>& results) const
+{
+  forEachOverlap (interval, [&results] (Id id) { results.push_back (id); });
+}
+
+template <typename Coord, typename Id>
+void
+ImplicitIntervalTree<Coord, Id>::pointSearchBatch (const Coord* points, size_t count,
+                                                   BatchResult& results) const
+{
+  results.offsets.resize (count + 1);
+  results.ids.clear ();
+  for (size_t i = 0; i < count; i++) {
+    results.offsets[i] = results.ids.size ();
+    pointSearch (points[i], results.ids);
+  }
+  results.offsets[count] = results.ids.size ();
+}
+
+template <typename Coord, typename Id>
+void
+ImplicitIntervalTree<Coord, Id>::pointSearchBatch (const std::vector<Coord>& points,
+                                                   BatchResult& results) const
+{
+  pointSearchBatch (points.data (), points.size (), results);
+}
+
+template <typename Coord, typename Id>
+Id
+ImplicitIntervalTree<Coord, Id>::pointCount (Coord point) const
+{
+  return intervalCount (std::make_pair (point, point));
+}
+
+template <typename Coord, typename Id>
+Id
+ImplicitIntervalTree<Coord, Id>::intervalCount (std::pair<Coord, Coord> interval) const
+{
+  Id count = 0;
+  forEachOverlap (interval, [&count] (Id) { count++; });
+  return count;
+}
+
+template <typename Coord, typename Id>
+std::vector<std::pair<Coord, Coord> >
+ImplicitIntervalTree<Coord, Id>::getStoredIntervalsCopy (void) const
+{
+  std::vector<std::pair<Coord, Coord> > intervals (entries.size ());
+  for (size_t i = 0; i < entries.size (); i++) {
+    intervals[i] = std::make_pair (entries[i].start, entries[i].end);
+  }
+  return intervals;
+}
+
+#endif
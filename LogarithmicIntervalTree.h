@@ -0,0 +1,222 @@
+#ifndef Logarithmic_Interval_Tree_Included
+#define Logarithmic_Interval_Tree_Included
+
+#include "CenteredIntervalTree.h"
+#include <vector>
+#include <memory>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+
+/* Dynamic interval set built from static CenteredIntervalTrees by the
+   logarithmic method of Bentley and Saxe. New intervals go into a small
+   unsorted buffer. When the buffer is full it is merged with runs 0, 1,
+   ... up to the first empty slot k, and the result becomes run k, so
+   run k never holds more than bufferSize << k intervals and every
+   interval is rebuilt O(log n) times: inserts cost amortized O(log n)
+   tree building work each. A query scans the buffer and asks each of
+   the O(log n) runs, at the speed of the static tree.
+
+   Every inserted interval gets a handle, which is stored in the runs as
+   the interval's payload and never changes when runs are merged. Removal
+   only marks the handle as removed; removed intervals stay in their run,
+   hidden from queries, until the run is next merged. Once more than
+   half the intervals held in runs are removed, all runs are merged into
+   one. One byte per handle ever handed out records whether it has been
+   removed. */
+template <typename Coord = double>
+class LogarithmicIntervalTree
+{
+  public:
+    typedef Coord coord_type;
+    typedef size_t handle_type;
+    typedef CenteredIntervalTree<Coord, int, size_t> Run;
+
+    explicit LogarithmicIntervalTree (size_t bufferSize = 256)
+      : buffer_size (bufferSize > 0 ? bufferSize : 1), num_live (0),
+        num_stored (0), num_removed (0)
+    {
+      buffer.reserve (buffer_size);
+    }
+
+    /* Adds an interval and returns its handle */
+    size_t insert (std::pair<Coord, Coord> interval)
+    {
+      size_t handle = removed.size ();
+      removed.push_back (0);
+      buffer.push_back (std::make_pair (interval, handle));
+      num_live++;
+      if (buffer.size () >= buffer_size) flushBuffer ();
+      return handle;
+    }
+
+    /* Removes the interval with the given handle. Returns false if there
+       is no such interval, e.g. because it was already removed. */
+    bool remove (size_t handle)
+    {
+      if (handle >= removed.size () || removed[handle]) return false;
+      removed[handle] = 1;
+      num_live--;
+
+      /* Intervals still in the buffer can simply be dropped */
+      for (size_t i = 0; i < buffer.size (); i++) {
+        if (buffer[i].second == handle) {
+          buffer[i] = buffer.back ();
+          buffer.pop_back ();
+          return true;
+        }
+      }
+
+      if (++num_removed * 2 > num_stored) compact ();
+      return true;
+    }
+
+    /* Number of intervals inserted and not removed */
+    size_t size () const { return num_live; }
+
+    /* Number of static runs currently holding intervals */
+    size_t numRuns () const
+    {
+      size_t count = 0;
+      for (size_t i = 0; i < runs.size (); i++) count += runs[i] != nullptr;
+      return count;
+    }
+
+    /* Call visit (handle) for every interval that contains the point */
+    template <typename F>
+    void forEachOverlap (Coord point, F&& visit) const
+    {
+      for (size_t i = 0; i < buffer.size (); i++) {
+        if (buffer[i].first.first <= point && point <= buffer[i].first.second) {
+          visit (buffer[i].second);
+        }
+      }
+      for (size_t i = 0; i < runs.size (); i++) {
+        if (runs[i]) runs[i]->forEachPayload (point, skipRemoved (visit));
+      }
+    }
+
+    /* Call visit (handle) for every interval that overlaps the requested
+       interval */
+    template <typename F>
+    void forEachOverlap (std::pair<Coord, Coord> interval, F&& visit) const
+    {
+      if (interval.first > interval.second) return;
+      for (size_t i = 0; i < buffer.size (); i++) {
+        if (buffer[i].first.first <= interval.second && interval.first <= buffer[i].first.second) {
+          visit (buffer[i].second);
+        }
+      }
+      for (size_t i = 0; i < runs.size (); i++) {
+        if (runs[i]) runs[i]->forEachPayload (interval, skipRemoved (visit));
+      }
+    }
+
+    /* Append the handles of the intervals that contain the point to
+       'results' */
+    void pointSearch (Coord point, std::vector<size_t>& results) const
+    {
+      forEachOverlap (point, [&results] (size_t handle) { results.push_back (handle); });
+    }
+
+    /* Append the handles of the intervals that overlap the requested
+       interval to 'results' */
+    void intervalSearch (std::pair<Coord, Coord> interval, std::vector<size_t>& results) const
+    {
+      forEachOverlap (interval, [&results] (size_t handle) { results.push_back (handle); });
+    }
+
+    static std::string name () {
+      return "Logarithmic Interval Tree";
+    }
+
+  private:
+    typedef std::pair<std::pair<Coord, Coord>, size_t> Entry;
+
+    /* Wraps visit so that it only sees handles that were not removed */
+    template <typename F>
+    auto skipRemoved (F& visit) const
+    {
+      return [this, &visit] (const size_t& handle) {
+        if (!removed[handle]) visit (handle);
+      };
+    }
+
+    /* Appends the intervals of 'run' that were not removed to 'entries',
+       and returns the number of removed ones left out */
+    size_t collectLive (const Run& run, std::vector<Entry>& entries) const
+    {
+      std::vector<std::pair<Coord, Coord> > intervals = run.getStoredIntervalsCopy ();
+      size_t dropped = 0;
+      for (size_t id = 0; id < intervals.size (); id++) {
+        size_t handle = run.payload (id);
+        if (removed[handle]) dropped++;
+        else entries.push_back (std::make_pair (intervals[id], handle));
+      }
+      return dropped;
+    }
+
+    /* Builds a run of 'entries' in slot 'level' */
+    void buildRun (const std::vector<Entry>& entries, size_t level)
+    {
+      if (runs.size () <= level) runs.resize (level + 1);
+      std::vector<std::pair<Coord, Coord> > intervals (entries.size ());
+      std::vector<size_t> handles (entries.size ());
+      for (size_t i = 0; i < entries.size (); i++) {
+        intervals[i] = entries[i].first;
+        handles[i] = entries[i].second;
+      }
+      runs[level].reset (entries.empty () ? nullptr : new Run (intervals, handles));
+    }
+
+    /* Merges the buffer and runs 0 .. k - 1 into the first empty slot k */
+    void flushBuffer ()
+    {
+      std::vector<Entry> entries;
+      entries.swap (buffer);
+      size_t merged = entries.size ();
+      size_t level = 0;
+      for (; level < runs.size () && runs[level]; level++) {
+        size_t dropped = collectLive (*runs[level], entries);
+        num_removed -= dropped;
+        num_stored -= dropped;
+        runs[level].reset ();
+      }
+      num_stored += merged;
+      buildRun (entries, level);
+      buffer.reserve (buffer_size);
+    }
+
+    /* Merges every run into one, dropping all removed intervals */
+    void compact ()
+    {
+      std::vector<Entry> entries;
+      for (size_t level = 0; level < runs.size (); level++) {
+        if (runs[level]) collectLive (*runs[level], entries);
+      }
+      runs.clear ();
+
+      size_t level = 0;
+      while ((buffer_size << level) < entries.size ()) level++;
+      num_stored = entries.size ();
+      num_removed = 0;
+      buildRun (entries, level);
+    }
+
+    size_t buffer_size;
+
+    /* Intervals not yet in any run, in no particular order */
+    std::vector<Entry> buffer;
+
+    /* runs[k] holds at most buffer_size << k intervals, or is empty */
+    std::vector<std::unique_ptr<Run> > runs;
+
+    /* removed[handle] is 1 once the interval with that handle is removed */
+    std::vector<uint8_t> removed;
+
+    size_t num_live;      /* Intervals inserted and not removed */
+    size_t num_stored;    /* Intervals held in runs, removed or not */
+    size_t num_removed;   /* Of those, the removed ones */
+};
+
+#endif
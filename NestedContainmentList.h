@@ -0,0 +1,357 @@
+#ifndef Nested_Containment_List_Included
+#define Nested_Containment_List_Included
+
+#include <vector>
+#include <algorithm>
+#include <unordered_set>
+#include <utility>        /* For std::pair */
+#include <string>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <stdexcept>
+#include "SortedSearch.h"
+
+/* Static nested containment list (NCList) of Alekseyenko and Lee. The
+   intervals not contained in any other form the top-level list, and the
+   intervals directly inside each interval form its sublist. No interval
+   in a list contains another, so sorted by start a list is also sorted
+   by end: a query finds the first interval of a list ending at or after
+   its start by binary search and scans forward until the starts pass its
+   end, descending into the sublist of every match. Nested data only
+   costs depth, where CenteredIntervalTree would put every long interval
+   into the lists of the few nodes near the root.
+
+   All lists are laid out depth-first in one set of arrays, each list
+   contiguous, and an interval's id is its position there. Every
+   interval records its sublist and the position of the interval whose
+   sublist it is in, so a query walks the lists with no stack. Same
+   query interface as CenteredIntervalTree. */
+template <typename Coord = double, typename Id = int>
+class NestedContainmentList
+{
+  static_assert (std::is_arithmetic<Coord>::value, "Coord must be an arithmetic type");
+  static_assert (std::is_integral<Id>::value, "Id must be an integer type");
+
+  public:
+    typedef Coord coord_type;
+    typedef Id id_type;
+
+    /* Given a list of intervals, constructs a new list holding these
+       elements. Throws std::length_error if there are too many intervals
+       to number with Id. */
+    NestedContainmentList (const std::vector<std::pair<Coord, Coord> >& intervals);
+
+    /* Return all the intervals in the list that contain the requested point */
+    std::unordered_set<Id> pointSearch (Coord point) const;
+
+    /* Append the intervals that contain the requested point to 'results' */
+    void pointSearch (Coord point, std::vector<Id>& results) const;
+
+    /* Return all the intervals in the list that overlap the requested interval */
+    std::unordered_set<Id> intervalSearch (std::pair<Coord, Coord> interval) const;
+
+    /* Append the intervals that overlap the requested interval to
+       'results'. An interval whose start is greater than its end
+       overlaps nothing. */
+    void intervalSearch (std::pair<Coord, Coord> interval, std::vector<Id>& results) const;
+
+    /* Call visit (id) for every interval that contains the requested point */
+    template <typename F>
+    void forEachOverlap (Coord point, F&& visit) const;
+
+    /* Call visit (id) for every interval that overlaps the requested interval */
+    template <typename F>
+    void forEachOverlap (std::pair<Coord, Coord> interval, F&& visit) const;
+
+    struct BatchResult;
+
+    /* Answer a point query for each of points[0, count), storing the
+       results in CSR form in 'results' (see BatchResult) */
+    void pointSearchBatch (const Coord* points, size_t count, BatchResult& results) const;
+    void pointSearchBatch (const std::vector<Coord>& points, BatchResult& results) const;
+
+    /* Return the number of intervals that contain the requested point,
+       found by walking the lists like a query */
+    Id pointCount (Coord point) const;
+
+    /* Return the number of intervals that overlap the requested interval */
+    Id intervalCount (std::pair<Coord, Coord> interval) const;
+
+    std::vector<std::pair<Coord, Coord> > getStoredIntervalsCopy (void) const;
+
+    static std::string name () {
+      return "Nested Containment List";
+    }
+
+  private:
+    static constexpr Id kNoParent = static_cast<Id> (-1);
+
+    /* Helper Functions */
+    static bool sortByContainment (const std::pair<Coord, Coord>& a, const std::pair<Coord, Coord>& b);
+    Id firstOverlap (Id begin, Id end, Coord start) const;
+
+    /* Endpoints of every interval, by id. Each list occupies one run. */
+    std::vector<Coord> starts;
+    std::vector<Coord> ends;
+
+    /* The sublist of interval i is [sublist_begin[i], sublist_end[i]) */
+    std::vector<Id> sublist_begin;
+    std::vector<Id> sublist_end;
+
+    /* The interval whose sublist interval i is in, or kNoParent for the
+       top-level list */
+    std::vector<Id> parents;
+
+    /* The top-level list is [0, top_end) */
+    Id top_end;
+};
+
+/* Results of a batched query in compressed sparse row form: the ids of
+   the intervals matching query i are ids[offsets[i], offsets[i + 1]). */
+template <typename Coord, typename Id>
+struct NestedContainmentList<Coord, Id>::BatchResult
+{
+  std::vector<size_t> offsets;
+  std::vector<Id> ids;
+};
+
+/* * * * * Implementation Below This Point * * * * */
+
+/* Orders intervals by start point and, among equal starts, longest
+   first, so every interval comes after all the intervals containing it */
+template <typename Coord, typename Id>
+bool
+NestedContainmentList<Coord, Id>::sortByContainment (const std::pair<Coord, Coord>& a,
+                                                     const std::pair<Coord, Coord>& b)
+{
+  if (a.first != b.first) return a.first < b.first;
+  return a.second > b.second;
+}
+
+template <typename Coord, typename Id>
+NestedContainmentList<Coord, Id>::NestedContainmentList (const std::vector<std::pair<Coord, Coord> >& intervals)
+  : top_end (0)
+{
+  if (intervals.size () >= (size_t) std::numeric_limits<Id>::max ()) {
+    throw std::length_error ("Too many intervals for the id type");
+  }
+
+  std::vector<std::pair<Coord, Coord> > sorted (intervals);
+  std::sort (sorted.begin (), sorted.end (), sortByContainment);
+  Id n = sorted.size ();
+
+  /* In containment order the intervals that may contain the next one are
+     exactly those on a stack of nested intervals; the innermost one
+     still reaching its end is its parent */
+  std::vector<Id> parent (n);
+  std::vector<Id> stack;
+  for (Id i = 0; i < n; i++) {
+    while (!stack.empty () && sorted[stack.back ()].second < sorted[i].second) {
+      stack.pop_back ();
+    }
+    parent[i] = stack.empty () ? kNoParent : stack.back ();
+    stack.push_back (i);
+  }
+
+  /* Group the intervals by parent, keeping them in start order within
+     each group. The top-level group comes first. */
+  std::vector<Id> child_begin (n + 2, 0);
+  for (Id i = 0; i < n; i++) {
+    child_begin[parent[i] == kNoParent ? 1 : parent[i] + 2]++;
+  }
+  for (Id i = 0; i <= n; i++) {
+    child_begin[i + 1] += child_begin[i];
+  }
+  std::vector<Id> children (n);
+  {
+    std::vector<Id> next (child_begin.begin (), child_begin.end () - 1);
+    for (Id i = 0; i < n; i++) {
+      children[next[parent[i] == kNoParent ? 0 : parent[i] + 1]++] = i;
+    }
+  }
+
+  /* Lay the lists out depth-first: the top-level list, then the sublist
+     of each of its intervals in turn, each followed by the sublists
+     nested in it. The lists a query descends into then tend to lie
+     next to the ones it has just read. */
+  std::vector<Id> position (n);
+  std::vector<Id> order (n);
+  Id placed = 0;
+  for (Id j = child_begin[0]; j < child_begin[1]; j++) {
+    position[children[j]] = placed;
+    order[placed++] = children[j];
+  }
+  top_end = placed;
+
+  starts.resize (n);
+  ends.resize (n);
+  sublist_begin.resize (n);
+  sublist_end.resize (n);
+  parents.resize (n);
+
+  /* Positions of the intervals whose sublists are still to be placed,
+     the next one last */
+  std::vector<Id> pending;
+  for (Id k = top_end; k > 0; k--) pending.push_back (k - 1);
+  while (!pending.empty ()) {
+    Id k = pending.back ();
+    pending.pop_back ();
+    Id i = order[k];
+    sublist_begin[k] = placed;
+    for (Id j = child_begin[i + 1]; j < child_begin[i + 2]; j++) {
+      position[children[j]] = placed;
+      order[placed++] = children[j];
+    }
+    sublist_end[k] = placed;
+    for (Id c = sublist_end[k]; c > sublist_begin[k]; c--) pending.push_back (c - 1);
+  }
+  for (Id k = 0; k < n; k++) {
+    Id i = order[k];
+    starts[k] = sorted[i].first;
+    ends[k] = sorted[i].second;
+    parents[k] = parent[i] == kNoParent ? kNoParent : position[parent[i]];
+  }
+}
+
+/* Position of the first interval in the list [begin, end) that ends at
+   or after 'start' */
+template <typename Coord, typename Id>
+Id
+NestedContainmentList<Coord, Id>::firstOverlap (Id begin, Id end, Coord start) const
+{
+  return begin + branchlessLowerBound (ends.data () + begin, end - begin, start);
+}
+
+/* Scans the current list from the first interval that ends at or after
+   the query start, while the intervals start at or before the query
+   end. After reporting an interval the walk goes down into its sublist
+   if anything there overlaps. When a list runs out it goes back up to
+   the interval after the parent, in the parent's list. */
+template <typename Coord, typename Id>
+template <typename F>
+void
+NestedContainmentList<Coord, Id>::forEachOverlap (std::pair<Coord, Coord> interval, F&& visit) const
+{
+  if (interval.first > interval.second) return;
+
+  const Coord start = interval.first;
+  const Coord end = interval.second;
+  Id list_end = top_end;
+  Id current = firstOverlap (0, top_end, start);
+  if (current == list_end || starts[current] > end) return;
+
+  for (;;) {
+    if (current < list_end && starts[current] <= end) {
+      visit (current);
+      Id child = firstOverlap (sublist_begin[current], sublist_end[current], start);
+      if (child < sublist_end[current] && starts[child] <= end) {
+        list_end = sublist_end[current];
+        current = child;
+      }
+      else {
+        current++;
+      }
+      continue;
+    }
+
+    /* current - 1 is the last interval reported from this list */
+    Id parent = parents[current - 1];
+    if (parent == kNoParent) return;
+    Id grandparent = parents[parent];
+    list_end = grandparent == kNoParent ? top_end : sublist_end[grandparent];
+    current = parent + 1;
+  }
+}
+
+template <typename Coord, typename Id>
+template <typename F>
+void
+NestedContainmentList<Coord, Id>::forEachOverlap (Coord point, F&& visit) const
+{
+  forEachOverlap (std::make_pair (point, point), visit);
+}
+
+template <typename Coord, typename Id>
+std::unordered_set<Id>
+NestedContainmentList<Coord, Id>::pointSearch (Coord point) const
+{
+  std::unordered_set<Id> intervals;
+  forEachOverlap (point, [&intervals] (Id id) { intervals.insert (id); });
+  return intervals;
+}
+
+template <typename Coord, typename Id>
+void
+NestedContainmentList<Coord, Id>::pointSearch (Coord point, std::vector<Id>& results) const
+{
+  forEachOverlap (point, [&results] (Id id) { results.push_back (id); });
+}
+
+template <typename Coord, typename Id>
+std::unordered_set<Id>
+NestedContainmentList<Coord, Id>::intervalSearch (std::pair<Coord, Coord> interval) const
+{
+  std::unordered_set<Id> overlaps;
+  forEachOverlap (interval, [&overlaps] (Id id) { overlaps.insert (id); });
+  return overlaps;
+}
+
+template <typename Coord, typename Id>
+void
+NestedContainmentList<Coord, Id>::intervalSearch (std::pair<Coord, Coord> interval,
+                                                  std::vector<Id>& results) const
+{
+  forEachOverlap (interval, [&results] (Id id) { results.push_back (id); });
+}
+
+template <typename Coord, typename Id>
+void
+NestedContainmentList<Coord, Id>::pointSearchBatch (const Coord* points, size_t count,
+                                                    BatchResult& results) const
+{
+  results.offsets.resize (count + 1);
+  results.ids.clear ();
+  for (size_t i = 0; i < count; i++) {
+    results.offsets[i] = results.ids.size ();
+    pointSearch (points[i], results.ids);
+  }
+  results.offsets[count] = results.ids.size ();
+}
+
+template <typename Coord, typename Id>
+void
+NestedContainmentList<Coord, Id>::pointSearchBatch (const std::vector<Coord>& points,
+                                                    BatchResult& results) const
+{
+  pointSearchBatch (points.data (), points.size (), results);
+}
+
+template <typename Coord, typename Id>
+Id
+NestedContainmentList<Coord, Id>::pointCount (Coord point) const
+{
+  return intervalCount (std::make_pair (point, point));
+}
+
+template <typename Coord, typename Id>
+Id
+NestedContainmentList<Coord, Id>::intervalCount (std::pair<Coord, Coord> interval) const
+{
+  Id count = 0;
+  forEachOverlap (interval, [&count] (Id) { count++; });
+  return count;
+}
+
+template <typename Coord, typename Id>
+std::vector<std::pair<Coord, Coord> >
+NestedContainmentList<Coord, Id>::getStoredIntervalsCopy (void) const
+{
+  std::vector<std::pair<Coord, Coord> > intervals (starts.size ());
+  for (size_t i = 0; i < starts.size (); i++) {
+    intervals[i] = std::make_pair (starts[i], ends[i]);
+  }
+  return intervals;
+}
+
+#endif
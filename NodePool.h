@@ -0,0 +1,206 @@
+#ifndef Node_Pool_Included
+#define Node_Pool_Included
+
+#include <vector>
+#include <new>          /* For ::operator new */
+#include <cstddef>
+
+/* Memory for the many small nodes of one tree. Blocks are carved out of
+   slabs in a fixed set of size classes, and a freed block goes on the
+   free list of its class, to be handed out again before the current
+   slab is touched. Slabs start at 64 kB and grow with the pool, each
+   new one an eighth of all slabs so far, so a structure whose size
+   wanders around a steady level soon has room in hand for its peaks.
+   Requests larger than the biggest small class, such as the buffers of
+   growing vectors, are rounded up to one of four sizes per power of
+   two. Those up to an eighth of a slab are carved from the slabs too;
+   bigger ones get a block of their own from operator new, which the
+   pool keeps a record of. Either way a freed large block goes on a free
+   list of its class. So a structure of steady size stops calling
+   malloc once the pool has grown to fit it. Memory only goes back to
+   the system when the pool is destroyed, all at once, so whatever was
+   allocated from it need not be freed one block at a time.
+
+   A pool is not thread safe and cannot be copied. */
+class NodePool
+{
+  public:
+    NodePool () : cursor (nullptr), limit (nullptr), slab_bytes (0)
+    {
+      for (size_t c = 0; c < kNumClasses; c++) free_lists[c] = nullptr;
+      for (size_t c = 0; c < kNumLargeClasses; c++) large_free_lists[c] = nullptr;
+    }
+
+    ~NodePool ()
+    {
+      for (size_t i = 0; i < slabs.size (); i++) ::operator delete (slabs[i]);
+      for (size_t i = 0; i < large_blocks.size (); i++) ::operator delete (large_blocks[i]);
+    }
+
+    NodePool (const NodePool&) = delete;
+    NodePool& operator= (const NodePool&) = delete;
+
+    void* allocate (size_t bytes)
+    {
+      if (bytes > kMaxBlock) return allocateLarge (bytes);
+
+      size_t c = sizeClass (bytes);
+      if (free_lists[c] != nullptr) {
+        FreeBlock* block = free_lists[c];
+        free_lists[c] = block->next;
+        return block;
+      }
+
+      return carve (classSize (c));
+    }
+
+    /* Returns a block to its free list. 'bytes' must be the size it was
+       allocated with. */
+    void deallocate (void* memory, size_t bytes)
+    {
+      FreeBlock* block = static_cast<FreeBlock*> (memory);
+      FreeBlock** list = bytes > kMaxBlock ? &large_free_lists[largeClass (bytes)]
+                                           : &free_lists[sizeClass (bytes)];
+      block->next = *list;
+      *list = block;
+    }
+
+  private:
+    struct FreeBlock {
+      FreeBlock* next;
+    };
+
+    /* Classes go up by 16 bytes to 256, by 64 to 1 kB and by 256 to
+       4 kB, so past 256 bytes no block is more than a quarter larger
+       than asked for. Every class is a multiple of 16 bytes, keeping
+       blocks 16-byte aligned. */
+    static const size_t kSlabBytes = 64 * 1024;
+    static const size_t kMaxBlock = 4096;
+    static const size_t kNumClasses = 40;
+
+    static size_t sizeClass (size_t bytes)
+    {
+      if (bytes <= 256) return bytes == 0 ? 0 : (bytes - 1) / 16;
+      if (bytes <= 1024) return 16 + (bytes - 257) / 64;
+      return 28 + (bytes - 1025) / 256;
+    }
+
+    static size_t classSize (size_t c)
+    {
+      if (c < 16) return (c + 1) * 16;
+      if (c < 28) return 256 + (c - 15) * 64;
+      return 1024 + (c - 27) * 256;
+    }
+
+    /* Past kMaxBlock, each power of two is split into four classes:
+       2^e + q 2^(e-2) for q = 1 to 4, e >= 12 */
+    static const size_t kNumLargeClasses = 4 * (64 - 12);
+
+    static size_t largeClass (size_t bytes)
+    {
+      size_t e = 63 - __builtin_clzll (bytes - 1);
+      size_t quarter = size_t (1) << (e - 2);
+      size_t q = (bytes - (size_t (1) << e) + quarter - 1) / quarter;
+      return (e - 12) * 4 + (q - 1);
+    }
+
+    static size_t largeClassSize (size_t c)
+    {
+      return (4 + c % 4 + 1) << (c / 4 + 12 - 2);
+    }
+
+    /* Size of the next slab: an eighth of all slabs so far, in whole
+       multiples of kSlabBytes */
+    size_t nextSlabBytes () const
+    {
+      size_t bytes = slab_bytes / 8 / kSlabBytes * kSlabBytes;
+      return bytes < kSlabBytes ? kSlabBytes : bytes;
+    }
+
+    /* A new block of 'size' bytes from the current slab, starting a new
+       slab if it is too short. The tail of the old slab is left unused. */
+    void* carve (size_t size)
+    {
+      if (size_t (limit - cursor) < size) {
+        size_t bytes = nextSlabBytes ();
+        reserveRecord (slabs);
+        cursor = static_cast<char*> (::operator new (bytes));
+        limit = cursor + bytes;
+        slabs.push_back (cursor);
+        slab_bytes += bytes;
+      }
+      void* block = cursor;
+      cursor += size;
+      return block;
+    }
+
+    /* Room for one more block in a record, growing it geometrically */
+    static void reserveRecord (std::vector<char*>& record)
+    {
+      if (record.size () == record.capacity ()) record.reserve (2 * record.size () + 16);
+    }
+
+    void* allocateLarge (size_t bytes)
+    {
+      size_t c = largeClass (bytes);
+      if (large_free_lists[c] != nullptr) {
+        FreeBlock* block = large_free_lists[c];
+        large_free_lists[c] = block->next;
+        return block;
+      }
+      size_t size = largeClassSize (c);
+      if (size <= nextSlabBytes () / 8) return carve (size);
+
+      /* Make room in the record first, so a failed push_back can't lose
+         the block */
+      reserveRecord (large_blocks);
+      char* block = static_cast<char*> (::operator new (size));
+      large_blocks.push_back (block);
+      return block;
+    }
+
+    FreeBlock* free_lists[kNumClasses];
+    FreeBlock* large_free_lists[kNumLargeClasses];
+
+    /* Unused part of the newest slab */
+    char* cursor;
+    char* limit;
+
+    std::vector<char*> slabs;
+
+    /* Size of all slabs together */
+    size_t slab_bytes;
+
+    /* Every large block that has a block of its own, in use or not */
+    std::vector<char*> large_blocks;
+};
+
+/* Standard allocator handing out memory from a NodePool, so that
+   containers can keep their storage in the pool of the structure that
+   owns them */
+template <typename T>
+class PoolAllocator
+{
+  public:
+    typedef T value_type;
+
+    explicit PoolAllocator (NodePool* pool) : pool (pool) {}
+
+    template <typename U>
+    PoolAllocator (const PoolAllocator<U>& other) : pool (other.pool) {}
+
+    T* allocate (size_t count) { return static_cast<T*> (pool->allocate (count * sizeof (T))); }
+    void deallocate (T* memory, size_t count) { pool->deallocate (memory, count * sizeof (T)); }
+
+    template <typename U>
+    bool operator== (const PoolAllocator<U>& other) const { return pool == other.pool; }
+    template <typename U>
+    bool operator!= (const PoolAllocator<U>& other) const { return pool != other.pool; }
+
+  private:
+    template <typename U> friend class PoolAllocator;
+
+    NodePool* pool;
+};
+
+#endif
@@ -0,0 +1,620 @@
+#ifndef Order_Statistic_Tree_Included
+#define Order_Statistic_Tree_Included
+
+#include <algorithm>
+#include <functional>   /* For std::less */
+#include <iterator>     /* For std::forward_iterator_tag */
+#include <memory>       /* For std::allocator, std::allocator_traits */
+#include <type_traits>  /* For std::is_trivially_destructible */
+#include <utility>      /* For std::swap */
+#include <cstddef>
+
+/* A sorted multiset kept in a B+ tree whose inner nodes record how many
+   elements lie below each child. Besides O(log n) insert and erase, it
+   can count the elements before a value in O(log n), and read the
+   elements in order from any point on, a leaf at a time. Equal elements
+   stay in the order they were inserted.
+
+   Elements are copied between nodes as they split and merge, so Value
+   should be small, default constructible and cheap to copy. Iterators
+   are invalidated by any insert or erase. Nodes come from Allocator. */
+template <typename Value, typename Comparator = std::less<Value>,
+          typename Allocator = std::allocator<Value> >
+class OrderStatisticTree
+{
+  public:
+    typedef Value value_type;
+
+    class iterator;
+    typedef iterator const_iterator;
+
+    explicit OrderStatisticTree (const Allocator& allocator = Allocator ())
+      : root (nullptr), levels (0), allocator (allocator) {}
+    OrderStatisticTree (const OrderStatisticTree& other);
+    OrderStatisticTree& operator= (OrderStatisticTree other);
+    ~OrderStatisticTree () { clear (); }
+
+    size_t size () const;
+    bool empty () const { return root == nullptr; }
+
+    /* Adds value after any elements equal to it */
+    void insert (const Value& value);
+
+    /* Removes the first element equal to value, if any. Returns whether
+       an element was removed. */
+    bool erase (const Value& value);
+
+    void clear ();
+    void swap (OrderStatisticTree& other);
+
+    /* Empties the tree without visiting or freeing its nodes, for when
+       all of the allocator's memory is about to be released at once, as
+       a NodePool's is on destruction */
+    void abandon ();
+
+    /* Number of elements less than value */
+    size_t countLess (const Value& value) const { return rank (value, false); }
+
+    /* Number of elements not greater than value */
+    size_t countLessOrEqual (const Value& value) const { return rank (value, true); }
+
+    /* The first element not less than value */
+    iterator lowerBound (const Value& value) const { return find (value, false); }
+
+    /* The first element greater than value */
+    iterator upperBound (const Value& value) const { return find (value, true); }
+
+    iterator begin () const;
+    iterator end () const { return iterator (nullptr, 0); }
+
+  private:
+    /* A leaf of small values spans 512 bytes to a kilobyte. Nodes other
+       than the root are kept at least a quarter full. */
+    static const size_t kLeafSize = sizeof (Value) <= 16 ? 64 : 32;
+    static const size_t kInnerSize = 32;
+    static const size_t kLeafMinimum = kLeafSize / 4;
+    static const size_t kInnerMinimum = kInnerSize / 4;
+
+    /* Leaves are chained in order for iteration */
+    struct Leaf {
+      size_t count;
+      Leaf* next;
+      Value items[kLeafSize];
+    };
+
+    /* children[i] holds sizes[i] elements, the greatest being maxes[i].
+       The children are leaves on the lowest inner level and inner nodes
+       above it. */
+    struct Inner {
+      size_t count;
+      size_t total;     /* Sum of sizes */
+      size_t sizes[kInnerSize];
+      Value maxes[kInnerSize];
+      void* children[kInnerSize];
+    };
+
+    static bool less (const Value& a, const Value& b) { return Comparator () (a, b); }
+
+    /* Helper Functions */
+    static size_t position (const Leaf* leaf, const Value& value, bool after);
+    static size_t childFor (const Inner* node, const Value& value, bool after);
+    static size_t nodeSize (const void* node, int level);
+    static size_t nodeCount (const void* node, int level);
+    static void describe (Inner* node, size_t i, int childLevel);
+    static void retotal (Inner* node);
+    static void removeEntry (Inner* node, size_t i);
+    template <typename Node> Node* newNode ();
+    template <typename Node> void freeNode (Node* node);
+    void destroy (void* node, int level);
+    void* insertInto (void* node, int level, const Value& value);
+    bool eraseFrom (void* node, int level, const Value& value);
+    void rebalance (Inner* node, size_t i, int childLevel);
+    size_t rank (const Value& value, bool after) const;
+    iterator find (const Value& value, bool after) const;
+
+    void* root;     /* A leaf when levels is 0, else an inner node */
+    int levels;     /* Inner levels above the leaves */
+    Allocator allocator;
+};
+
+/* Forward iterator over the elements in order */
+template <typename Value, typename Comparator, typename Allocator>
+class OrderStatisticTree<Value, Comparator, Allocator>::iterator
+{
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Value value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const Value* pointer;
+    typedef const Value& reference;
+
+    iterator () : leaf (nullptr), pos (0) {}
+
+    reference operator* () const { return leaf->items[pos]; }
+    pointer operator-> () const { return &leaf->items[pos]; }
+
+    iterator& operator++ ()
+    {
+      if (++pos == leaf->count) {
+        leaf = leaf->next;
+        pos = 0;
+      }
+      return *this;
+    }
+
+    iterator operator++ (int)
+    {
+      iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    bool operator== (const iterator& other) const { return leaf == other.leaf && pos == other.pos; }
+    bool operator!= (const iterator& other) const { return !(*this == other); }
+
+  private:
+    friend class OrderStatisticTree;
+
+    iterator (const Leaf* leaf, size_t pos) : leaf (leaf), pos (pos) {}
+
+    const Leaf* leaf;
+    size_t pos;
+};
+
+/* * * * * Implementation Below This Point * * * * */
+
+template <typename Value, typename Comparator, typename Allocator>
+OrderStatisticTree<Value, Comparator, Allocator>::OrderStatisticTree (const OrderStatisticTree& other)
+  : root (nullptr), levels (0),
+    allocator (std::allocator_traits<Allocator>::select_on_container_copy_construction (other.allocator))
+{
+  for (iterator it = other.begin (); it != other.end (); ++it) {
+    insert (*it);
+  }
+}
+
+template <typename Value, typename Comparator, typename Allocator>
+OrderStatisticTree<Value, Comparator, Allocator>&
+OrderStatisticTree<Value, Comparator, Allocator>::operator= (OrderStatisticTree other)
+{
+  swap (other);
+  return *this;
+}
+
+template <typename Value, typename Comparator, typename Allocator>
+void
+OrderStatisticTree<Value, Comparator, Allocator>::swap (OrderStatisticTree& other)
+{
+  std::swap (root, other.root);
+  std::swap (levels, other.levels);
+  std::swap (allocator, other.allocator);
+}
+
+template <typename Value, typename Comparator, typename Allocator>
+void
+OrderStatisticTree<Value, Comparator, Allocator>::clear ()
+{
+  if (root != nullptr) destroy (root, levels);
+  root = nullptr;
+  levels = 0;
+}
+
+template <typename Value, typename Comparator, typename Allocator>
+void
+OrderStatisticTree<Value, Comparator, Allocator>::abandon ()
+{
+  static_assert (std::is_trivially_destructible<Value>::value,
+                 "Abandoned elements are never destroyed");
+  root = nullptr;
+  levels = 0;
+}
+
+template <typename Value, typename Comparator, typename Allocator>
+void
+OrderStatisticTree<Value, Comparator, Allocator>::destroy (void* node, int level)
+{
+  if (level == 0) {
+    freeNode (static_cast<Leaf*> (node));
+    return;
+  }
+  Inner* inner = static_cast<Inner*> (node);
+  for (size_t i = 0; i < inner->count; i++) {
+    destroy (inner->children[i], level - 1);
+  }
+  freeNode (inner);
+}
+
+template <typename Value, typename Comparator, typename Allocator>
+template <typename Node>
+Node*
+OrderStatisticTree<Value, Comparator, Allocator>::newNode ()
+{
+  typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Node> NodeAllocator;
+  NodeAllocator nodes (allocator);
+  Node* node = std::allocator_traits<NodeAllocator>::allocate (nodes, 1);
+  return new (node) Node;
+}
+
+template <typename Value, typename Comparator, typename Allocator>
+template <typename Node>
+void
+OrderStatisticTree<Value, Comparator, Allocator>::freeNode (Node* node)
+{
+  typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Node> NodeAllocator;
+  NodeAllocator nodes (allocator);
+  node->~Node ();
+  std::allocator_traits<NodeAllocator>::deallocate (nodes, node, 1);
+}
+
+template <typename Value, typename Comparator, typename Allocator>
+size_t
+OrderStatisticTree<Value, Comparator, Allocator>::size () const
+{
+  return root == nullptr ? 0 : nodeSize (root, levels);
+}
+
+template <typename Value, typename Comparator, typename Allocator>
+size_t
+OrderStatisticTree<Value, Comparator, Allocator>::nodeSize (const void* node, int level)
+{
+  if (level == 0) return static_cast<const Leaf*> (node)->count;
+  return static_cast<const Inner*> (node)->total;
+}
+
+/* Number of elements in a leaf, or children of an inner node */
+template <typename Value, typename Comparator, typename Allocator>
+size_t
+OrderStatisticTree<Value, Comparator, Allocator>::nodeCount (const void* node, int level)
+{
+  if (level == 0) return static_cast<const Leaf*> (node)->count;
+  return static_cast<const Inner*> (node)->count;
+}
+
+/* Index in the leaf of the first element not less than value, or with
+   'after' of the first element greater than it */
+template <typename Value, typename Comparator, typename Allocator>
+size_t
+OrderStatisticTree<Value, Comparator, Allocator>::position (const Leaf* leaf, const Value& value, bool after)
+{
+  size_t lo = 0, count = leaf->count;
+  while (count > 0) {
+    size_t half = count / 2;
+    const Value& item = leaf->items[lo + half];
+    if (after ? !less (value, item) : less (item, value)) {
+      lo += half + 1;
+      count -= half + 1;
+    }
+    else {
+      count = half;
+    }
+  }
+  return lo;
+}
+
+/* The first child holding an element not less than value, or with
+   'after' one greater than it. Returns node->count if there is none. */
+template <typename Value, typename Comparator, typename Allocator>
+size_t
+OrderStatisticTree<Value, Comparator, Allocator>::childFor (const Inner* node, const Value& value, bool after)
+{
+  size_t i = 0;
+  while (i < node->count && (after ? !less (value, node->maxes[i]) : less (node->maxes[i], value))) {
+    i++;
+  }
+  return i;
+}
+
+/* Updates the size and max of child i from the child itself */
+template <typename Value, typename Comparator, typename Allocator>
+void
+OrderStatisticTree<Value, Comparator, Allocator>::describe (Inner* node, size_t i, int childLevel)
+{
+  if (childLevel == 0) {
+    const Leaf* child = static_cast<const Leaf*> (node->children[i]);
+    node->sizes[i] = child->count;
+    node->maxes[i] = child->items[child->count - 1];
+  }
+  else {
+    const Inner* child = static_cast<const Inner*> (node->children[i]);
+    node->sizes[i] = child->total;
+    node->maxes[i] = child->maxes[child->count - 1];
+  }
+}
+
+template <typename Value, typename Comparator, typename Allocator>
+void
+OrderStatisticTree<Value, Comparator, Allocator>::retotal (Inner* node)
+{
+  node->total = 0;
+  for (size_t i = 0; i < node->count; i++) {
+    node->total += node->sizes[i];
+  }
+}
+
+template <typename Value, typename Comparator, typename Allocator>
+void
+OrderStatisticTree<Value, Comparator, Allocator>::removeEntry (Inner* node, size_t i)
+{
+  std::copy (node->sizes + i + 1, node->sizes + node->count, node->sizes + i);
+  std::copy (node->maxes + i + 1, node->maxes + node->count, node->maxes + i);
+  std::copy (node->children + i + 1, node->children + node->count, node->children + i);
+  node->count--;
+}
+
+template <typename Value, typename Comparator, typename Allocator>
+void
+OrderStatisticTree<Value, Comparator, Allocator>::insert (const Value& value)
+{
+  if (root == nullptr) {
+    Leaf* leaf = newNode<Leaf> ();
+    leaf->count = 0;
+    leaf->next = nullptr;
+    root = leaf;
+  }
+
+  /* A split root gets a new root above it */
+  void* sibling = insertInto (root, levels, value);
+  if (sibling != nullptr) {
+    Inner* top = newNode<Inner> ();
+    top->count = 2;
+    top->children[0] = root;
+    top->children[1] = sibling;
+    describe (top, 0, levels);
+    describe (top, 1, levels);
+    retotal (top);
+    root = top;
+    levels++;
+  }
+}
+
+/* Inserts value below 'node', splitting full nodes on the way back up.
+   Returns the new right half of 'node' if it was split. */
+template <typename Value, typename Comparator, typename Allocator>
+void*
+OrderStatisticTree<Value, Comparator, Allocator>::insertInto (void* node, int level, const Value& value)
+{
+  if (level == 0) {
+    Leaf* leaf = static_cast<Leaf*> (node);
+    size_t pos = position (leaf, value, true);
+    Leaf* sibling = nullptr;
+    if (leaf->count == kLeafSize) {
+      size_t half = kLeafSize / 2;
+      sibling = newNode<Leaf> ();
+      std::copy (leaf->items + half, leaf->items + kLeafSize, sibling->items);
+      sibling->count = kLeafSize - half;
+      sibling->next = leaf->next;
+      leaf->count = half;
+      leaf->next = sibling;
+      if (pos > half) {
+        leaf = sibling;
+        pos -= half;
+      }
+    }
+    std::copy_backward (leaf->items + pos, leaf->items + leaf->count, leaf->items + leaf->count + 1);
+    leaf->items[pos] = value;
+    leaf->count++;
+    return sibling;
+  }
+
+  Inner* inner = static_cast<Inner*> (node);
+  size_t i = std::min (childFor (inner, value, true), inner->count - 1);
+  void* split = insertInto (inner->children[i], level - 1, value);
+  describe (inner, i, level - 1);
+  if (split == nullptr) {
+    inner->total++;
+    return nullptr;
+  }
+
+  /* The split child's right half goes in after it */
+  Inner* sibling = nullptr;
+  size_t at = i + 1;
+  if (inner->count == kInnerSize) {
+    size_t half = kInnerSize / 2;
+    sibling = newNode<Inner> ();
+    std::copy (inner->sizes + half, inner->sizes + kInnerSize, sibling->sizes);
+    std::copy (inner->maxes + half, inner->maxes + kInnerSize, sibling->maxes);
+    std::copy (inner->children + half, inner->children + kInnerSize, sibling->children);
+    sibling->count = kInnerSize - half;
+    inner->count = half;
+    if (at > half) {
+      inner = sibling;
+      at -= half;
+    }
+  }
+  std::copy_backward (inner->sizes + at, inner->sizes + inner->count, inner->sizes + inner->count + 1);
+  std::copy_backward (inner->maxes + at, inner->maxes + inner->count, inner->maxes + inner->count + 1);
+  std::copy_backward (inner->children + at, inner->children + inner->count, inner->children + inner->count + 1);
+  inner->children[at] = split;
+  inner->count++;
+  describe (inner, at, level - 1);
+  retotal (inner);
+  if (sibling != nullptr) {
+    retotal (sibling);
+    retotal (static_cast<Inner*> (node));
+  }
+  return sibling;
+}
+
+template <typename Value, typename Comparator, typename Allocator>
+bool
+OrderStatisticTree<Value, Comparator, Allocator>::erase (const Value& value)
+{
+  if (root == nullptr || !eraseFrom (root, levels, value)) return false;
+
+  /* An emptied leaf root goes, and a root with one child is replaced by it */
+  if (levels == 0) {
+    if (static_cast<Leaf*> (root)->count == 0) clear ();
+  }
+  else if (static_cast<Inner*> (root)->count == 1) {
+    Inner* old = static_cast<Inner*> (root);
+    root = old->children[0];
+    levels--;
+    freeNode (old);
+  }
+  return true;
+}
+
+/* Removes the first element equal to value below 'node'. A child left
+   less than a quarter full is merged with or refilled from a neighbour,
+   so only the root may be sparse. */
+template <typename Value, typename Comparator, typename Allocator>
+bool
+OrderStatisticTree<Value, Comparator, Allocator>::eraseFrom (void* node, int level, const Value& value)
+{
+  if (level == 0) {
+    Leaf* leaf = static_cast<Leaf*> (node);
+    size_t pos = position (leaf, value, false);
+    if (pos == leaf->count || less (value, leaf->items[pos])) return false;
+    std::copy (leaf->items + pos + 1, leaf->items + leaf->count, leaf->items + pos);
+    leaf->count--;
+    return true;
+  }
+
+  Inner* inner = static_cast<Inner*> (node);
+  size_t i = childFor (inner, value, false);
+  if (i == inner->count || !eraseFrom (inner->children[i], level - 1, value)) return false;
+  inner->total--;
+
+  size_t minimum = level == 1 ? kLeafMinimum : kInnerMinimum;
+  if (inner->count > 1 && nodeCount (inner->children[i], level - 1) < minimum) {
+    rebalance (inner, i, level - 1);
+  }
+  else {
+    describe (inner, i, level - 1);
+  }
+  return true;
+}
+
+/* Merges child i of 'node' with a neighbour if the two fit in one node,
+   and otherwise evens out their counts */
+template <typename Value, typename Comparator, typename Allocator>
+void
+OrderStatisticTree<Value, Comparator, Allocator>::rebalance (Inner* node, size_t i, int childLevel)
+{
+  size_t a = i + 1 < node->count ? i : i - 1;
+  size_t b = a + 1;
+
+  if (childLevel == 0) {
+    Leaf* left = static_cast<Leaf*> (node->children[a]);
+    Leaf* right = static_cast<Leaf*> (node->children[b]);
+    size_t total = left->count + right->count;
+    if (total <= kLeafSize) {
+      std::copy (right->items, right->items + right->count, left->items + left->count);
+      left->count = total;
+      left->next = right->next;
+      freeNode (right);
+      removeEntry (node, b);
+      describe (node, a, childLevel);
+      return;
+    }
+    size_t want = total / 2;
+    if (left->count > want) {
+      size_t moved = left->count - want;
+      std::copy_backward (right->items, right->items + right->count, right->items + right->count + moved);
+      std::copy (left->items + want, left->items + left->count, right->items);
+    }
+    else {
+      size_t moved = want - left->count;
+      std::copy (right->items, right->items + moved, left->items + left->count);
+      std::copy (right->items + moved, right->items + right->count, right->items);
+    }
+    right->count = total - want;
+    left->count = want;
+  }
+  else {
+    Inner* left = static_cast<Inner*> (node->children[a]);
+    Inner* right = static_cast<Inner*> (node->children[b]);
+    size_t total = left->count + right->count;
+    if (total <= kInnerSize) {
+      std::copy (right->sizes, right->sizes + right->count, left->sizes + left->count);
+      std::copy (right->maxes, right->maxes + right->count, left->maxes + left->count);
+      std::copy (right->children, right->children + right->count, left->children + left->count);
+      left->count = total;
+      retotal (left);
+      freeNode (right);
+      removeEntry (node, b);
+      describe (node, a, childLevel);
+      return;
+    }
+    size_t want = total / 2;
+    if (left->count > want) {
+      size_t moved = left->count - want;
+      std::copy_backward (right->sizes, right->sizes + right->count, right->sizes + right->count + moved);
+      std::copy_backward (right->maxes, right->maxes + right->count, right->maxes + right->count + moved);
+      std::copy_backward (right->children, right->children + right->count,
+                          right->children + right->count + moved);
+      std::copy (left->sizes + want, left->sizes + left->count, right->sizes);
+      std::copy (left->maxes + want, left->maxes + left->count, right->maxes);
+      std::copy (left->children + want, left->children + left->count, right->children);
+    }
+    else {
+      size_t moved = want - left->count;
+      std::copy (right->sizes, right->sizes + moved, left->sizes + left->count);
+      std::copy (right->maxes, right->maxes + moved, left->maxes + left->count);
+      std::copy (right->children, right->children + moved, left->children + left->count);
+      std::copy (right->sizes + moved, right->sizes + right->count, right->sizes);
+      std::copy (right->maxes + moved, right->maxes + right->count, right->maxes);
+      std::copy (right->children + moved, right->children + right->count, right->children);
+    }
+    right->count = total - want;
+    left->count = want;
+    retotal (left);
+    retotal (right);
+  }
+  describe (node, a, childLevel);
+  describe (node, b, childLevel);
+}
+
+/* Number of elements less than value, or with 'after' not greater */
+template <typename Value, typename Comparator, typename Allocator>
+size_t
+OrderStatisticTree<Value, Comparator, Allocator>::rank (const Value& value, bool after) const
+{
+  if (root == nullptr) return 0;
+
+  size_t count = 0;
+  const void* node = root;
+  for (int level = levels; level > 0; level--) {
+    const Inner* inner = static_cast<const Inner*> (node);
+    size_t i = childFor (inner, value, after);
+    for (size_t j = 0; j < i; j++) count += inner->sizes[j];
+    if (i == inner->count) return count;
+    node = inner->children[i];
+  }
+  return count + position (static_cast<const Leaf*> (node), value, after);
+}
+
+/* The first element not less than value, or with 'after' greater */
+template <typename Value, typename Comparator, typename Allocator>
+typename OrderStatisticTree<Value, Comparator, Allocator>::iterator
+OrderStatisticTree<Value, Comparator, Allocator>::find (const Value& value, bool after) const
+{
+  if (root == nullptr) return end ();
+
+  const void* node = root;
+  for (int level = levels; level > 0; level--) {
+    const Inner* inner = static_cast<const Inner*> (node);
+    size_t i = childFor (inner, value, after);
+    if (i == inner->count) return end ();
+    node = inner->children[i];
+  }
+  const Leaf* leaf = static_cast<const Leaf*> (node);
+  size_t pos = position (leaf, value, after);
+  if (pos == leaf->count) return iterator (leaf->next, 0);
+  return iterator (leaf, pos);
+}
+
+template <typename Value, typename Comparator, typename Allocator>
+typename OrderStatisticTree<Value, Comparator, Allocator>::iterator
+OrderStatisticTree<Value, Comparator, Allocator>::begin () const
+{
+  if (root == nullptr) return end ();
+
+  const void* node = root;
+  for (int level = levels; level > 0; level--) {
+    node = static_cast<const Inner*> (node)->children[0];
+  }
+  return iterator (static_cast<const Leaf*> (node), 0);
+}
+
+#endif
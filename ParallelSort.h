@@ -0,0 +1,64 @@
+#ifndef Parallel_Sort_Included
+#define Parallel_Sort_Included
+
+#include "ThreadPool.h"
+#include <algorithm>
+#include <vector>
+#include <cstddef>
+#include <functional>   /* For std::less */
+#include <iterator>     /* For std::iterator_traits */
+
+/* Below this many elements the range is sorted on the calling thread */
+static const size_t kMinParallelSort = 1 << 14;
+
+/* Sorts [first, last) with comp on the given pool: one chunk per thread is
+   sorted with std::sort, then neighbouring chunks are merged pairwise in
+   parallel rounds. For a strict total order the result is the same as
+   std::sort's. */
+template <typename RandomIt, typename Compare>
+void
+parallelSort (RandomIt first, RandomIt last, Compare comp, ThreadPool& pool)
+{
+  size_t n = last - first;
+  size_t chunks = pool.size () + 1;
+  if (chunks < 2 || n < kMinParallelSort) {
+    std::sort (first, last, comp);
+    return;
+  }
+
+  std::vector<size_t> bounds;
+  for (size_t i = 0; i <= chunks; i++) {
+    bounds.push_back (n * i / chunks);
+  }
+
+  {
+    TaskGroup group (pool);
+    for (size_t i = 0; i < chunks; i++) {
+      size_t begin = bounds[i], end = bounds[i + 1];
+      group.run ([=] () { std::sort (first + begin, first + end, comp); });
+    }
+    group.wait ();
+  }
+
+  for (size_t width = 1; width < chunks; width *= 2) {
+    TaskGroup group (pool);
+    for (size_t i = 0; i + width < chunks; i += 2 * width) {
+      size_t begin = bounds[i];
+      size_t middle = bounds[i + width];
+      size_t end = bounds[std::min (i + 2 * width, chunks)];
+      group.run ([=] () {
+        std::inplace_merge (first + begin, first + middle, first + end, comp);
+      });
+    }
+    group.wait ();
+  }
+}
+
+template <typename RandomIt>
+void
+parallelSort (RandomIt first, RandomIt last, ThreadPool& pool)
+{
+  parallelSort (first, last, std::less<typename std::iterator_traits<RandomIt>::value_type> (), pool);
+}
+
+#endif
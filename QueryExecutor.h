@@ -0,0 +1,106 @@
+#ifndef Query_Executor_Included
+#define Query_Executor_Included
+
+#include "ThreadPool.h"
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <cstddef>
+
+/* Answers large batches of queries against one shared, read-only tree
+   on a fixed pool of threads. A batch is cut into contiguous chunks,
+   each chunk is answered into its own scratch result, and the chunks are
+   then copied together in batch order into one CSR result (see
+   Tree::BatchResult). The scratch results are kept between batches, so
+   a steady stream of similar batches reuses the same memory.
+
+   The executor itself is not thread-safe; run one executor per thread
+   that submits batches. */
+template <typename Tree>
+class QueryExecutor
+{
+  public:
+    typedef typename Tree::BatchResult BatchResult;
+    typedef typename Tree::coord_type Coord;
+
+    /* Uses numThreads threads in total, counting the calling thread */
+    QueryExecutor (const Tree& tree, unsigned numThreads)
+      : tree (tree), pool (numThreads > 1 ? numThreads - 1 : 0) {}
+
+    /* Point query for every element of 'points' */
+    void pointSearch (const std::vector<Coord>& points, BatchResult& results)
+    {
+      runChunks (points.size (), results, [this, &points] (size_t begin, size_t end, BatchResult& chunk) {
+        tree.pointSearchBatch (points.data () + begin, end - begin, chunk);
+      });
+    }
+
+    /* Interval query for every element of 'intervals' */
+    void intervalSearch (const std::vector<std::pair<Coord, Coord> >& intervals, BatchResult& results)
+    {
+      runChunks (intervals.size (), results, [this, &intervals] (size_t begin, size_t end, BatchResult& chunk) {
+        chunk.offsets.clear ();
+        chunk.ids.clear ();
+        for (size_t i = begin; i < end; i++) {
+          chunk.offsets.push_back (chunk.ids.size ());
+          tree.intervalSearch (intervals[i], chunk.ids);
+        }
+        chunk.offsets.push_back (chunk.ids.size ());
+      });
+    }
+
+  private:
+    /* More chunks than threads lets threads that finish early pick up
+       the work of ones stuck with expensive queries */
+    static const size_t kChunksPerThread = 4;
+
+    const Tree& tree;
+    ThreadPool pool;
+    std::vector<BatchResult> scratch;
+
+    /* Answers queries [0, count) with answerChunk (begin, end, chunk),
+       one chunk per task, then merges the chunks into 'results' */
+    template <typename F>
+    void runChunks (size_t count, BatchResult& results, F answerChunk)
+    {
+      size_t numChunks = std::min (count, (pool.size () + 1) * kChunksPerThread);
+      if (scratch.size () < numChunks) scratch.resize (numChunks);
+
+      {
+        TaskGroup group (pool);
+        for (size_t i = 0; i < numChunks; i++) {
+          group.run ([this, &answerChunk, count, numChunks, i] () {
+            answerChunk (count * i / numChunks, count * (i + 1) / numChunks, scratch[i]);
+          });
+        }
+        group.wait ();
+      }
+
+      /* Every chunk's ids land after those of the chunks before it */
+      std::vector<size_t> bases (numChunks + 1, 0);
+      for (size_t i = 0; i < numChunks; i++) {
+        bases[i + 1] = bases[i] + scratch[i].ids.size ();
+      }
+      results.offsets.resize (count + 1);
+      results.ids.resize (bases[numChunks]);
+
+      {
+        TaskGroup group (pool);
+        for (size_t i = 0; i < numChunks; i++) {
+          group.run ([this, &results, &bases, count, numChunks, i] () {
+            const BatchResult& chunk = scratch[i];
+            size_t begin = count * i / numChunks;
+            size_t end = count * (i + 1) / numChunks;
+            for (size_t row = begin; row < end; row++) {
+              results.offsets[row] = bases[i] + chunk.offsets[row - begin];
+            }
+            std::copy (chunk.ids.begin (), chunk.ids.end (), results.ids.begin () + bases[i]);
+          });
+        }
+        group.wait ();
+      }
+      results.offsets[count] = bases[numChunks];
+    }
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef Radix_Sort_Included
+#define Radix_Sort_Included
+
+#include <vector>
+#include <algorithm>    /* For std::copy */
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <utility>      /* For std::swap */
+
+/* Stable LSD radix sort of [first, last) by the integral key keyOf (item),
+   one byte per pass. The histograms of all the passes are taken in one
+   read of the input, and a pass is skipped when every key has the same
+   byte there, so keys spanning a small range cost only a pass or two.
+   Signed keys are ordered by flipping their sign bit. Uses one buffer
+   the size of the input. */
+template <typename T, typename KeyOf>
+void
+radixSort (T* first, T* last, KeyOf keyOf)
+{
+  typedef typename std::decay<decltype (keyOf (*first))>::type Key;
+  typedef typename std::make_unsigned<Key>::type Bits;
+  static_assert (std::is_integral<Key>::value, "radixSort needs an integral key");
+
+  const size_t kPasses = sizeof (Key);
+  const Bits kFlip = std::is_signed<Key>::value
+                     ? Bits (1) << (std::numeric_limits<Bits>::digits - 1) : 0;
+  size_t n = last - first;
+  if (n < 2) return;
+
+  std::vector<size_t> counts (kPasses * 256, 0);
+  for (size_t i = 0; i < n; i++) {
+    Bits bits = Bits (keyOf (first[i])) ^ kFlip;
+    for (size_t pass = 0; pass < kPasses; pass++) {
+      counts[pass * 256 + ((bits >> (8 * pass)) & 0xFF)]++;
+    }
+  }
+
+  std::vector<T> buffer (n);
+  T* from = first;
+  T* to = buffer.data ();
+  for (size_t pass = 0; pass < kPasses; pass++) {
+    size_t* count = &counts[pass * 256];
+    Bits firstByte = ((Bits (keyOf (*from)) ^ kFlip) >> (8 * pass)) & 0xFF;
+    if (count[firstByte] == n) continue;
+
+    /* Turn the counts into the position of each bucket */
+    size_t position = 0;
+    for (int digit = 0; digit < 256; digit++) {
+      size_t size = count[digit];
+      count[digit] = position;
+      position += size;
+    }
+    for (size_t i = 0; i < n; i++) {
+      Bits bits = Bits (keyOf (from[i])) ^ kFlip;
+      to[count[(bits >> (8 * pass)) & 0xFF]++] = from[i];
+    }
+    std::swap (from, to);
+  }
+
+  if (from != first) {
+    std::copy (from, from + n, first);
+  }
+}
+
+#endif
@@ -51,27 +51,38 @@
 
 #include <algorithm>   // For lexicographical_compare, equal, max
 #include <functional>  // For less
-#include <utility>     // For pair
-#include <iterator>    // For iterator
-#include <cstring>     // For memset
-#include <cstdlib>     // For rand
+#include <utility>     // For pair, move, forward, piecewise_construct
+#include <tuple>       // For forward_as_tuple
+#include <iterator>    // For forward_iterator_tag
+#include <cstddef>     // For ptrdiff_t
+#include <cstring>     // For memset, memcpy
+#include <cstdint>     // For uint64_t
+#include <memory>      // For allocator, allocator_traits
 #include <stdexcept>   // For out_of_range
 
 /**
  * A map-like class backed by a ReverseSkiplist.
  */
-template <typename Key, typename Value, typename Comparator = std::greater<Key> >
+template <typename Key, typename Value, typename Comparator = std::greater<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, Value> > >
 class ReverseSkiplist {
 public:
   /**
-   * Constructor: ReverseSkiplist(Comparator comp = Comparator());
+   * Constructor: ReverseSkiplist(Comparator comp = Comparator(),
+   *                              const Allocator& alloc = Allocator(),
+   *                              uint64_t seed = kDefaultSeed);
    * Usage: ReverseSkiplist<string, int> myReverseSkiplist;
    * Usage: ReverseSkiplist<string, int> myReverseSkiplist(MyComparisonFunction);
+   * Usage: ReverseSkiplist<string, int> myReverseSkiplist(std::greater<string>(), myAllocator, 42);
    * -------------------------------------------------------------------------
    * Constructs a new, empty ReverseSkiplist that uses the indicated comparator to
-   * compare keys.
+   * compare keys and the indicated allocator to obtain memory for its nodes.
+   * Node levels are drawn from a random number generator owned by this
+   * ReverseSkiplist and started from the given seed, so two ReverseSkiplists built with the
+   * same seed and fed the same operations have exactly the same shape.
    */
-  ReverseSkiplist(Comparator comp = Comparator());
+  ReverseSkiplist(Comparator comp = Comparator(), const Allocator& alloc = Allocator(),
+                  uint64_t seed = kDefaultSeed);
 
   /**
    * Destructor: ~ReverseSkiplist();
@@ -92,6 +103,18 @@ public:
   ReverseSkiplist(const ReverseSkiplist& other);
   ReverseSkiplist& operator= (const ReverseSkiplist& other);
 
+  /**
+   * Move functions: ReverseSkiplist(ReverseSkiplist&& other);
+   *                 ReverseSkiplist& operator= (ReverseSkiplist&& other);
+   * Usage: ReverseSkiplist<string, int> one = std::move(two);
+   *        one = std::move(two);
+   * -------------------------------------------------------------------------
+   * Takes over the nodes of some other ReverseSkiplist without copying them, leaving
+   * the other ReverseSkiplist empty.
+   */
+  ReverseSkiplist(ReverseSkiplist&& other) noexcept;
+  ReverseSkiplist& operator= (ReverseSkiplist&& other) noexcept;
+
   /**
    * Type: iterator
    * Type: const_iterator
@@ -113,6 +136,17 @@ public:
    */
   std::pair<iterator, bool> insert(const Key& key, const Value& value);
 
+  /**
+   * std::pair<iterator, bool> emplace(const Key& key, Args&&... args);
+   * Usage: myReverseSkiplist.emplace("ReverseSkiplist", 137);
+   * -------------------------------------------------------------------------
+   * Like insert, but the value is constructed inside the new node from the
+   * given arguments rather than copied into it.  If the key is already
+   * present, nothing is constructed.
+   */
+  template <typename... Args>
+  std::pair<iterator, bool> emplace(const Key& key, Args&&... args);
+
   /**
    * bool erase(const Key& key);
    * Usage: myReverseSkiplist.erase("AVL Tree");
@@ -194,9 +228,18 @@ public:
   void swap(ReverseSkiplist& other);
 
 private:
+  /* Nodes are allocated through the user's allocator as a run of NodeUnits,
+   * each the size and alignment of a Node, since a node's real size depends
+   * on its level.
+   */
+  struct Node;
+  struct NodeUnit;
+  typedef typename std::allocator_traits<Allocator>::template
+    rebind_alloc<NodeUnit> NodeAllocator;
+
   /* A type representing a node in the ReverseSkiplist.  This node is designed to
-   * be allocated on the heap with the number of extra pointers required
-   * specified as an argument to operator new.
+   * be allocated with the number of extra pointers required specified as an
+   * argument to operator new.
    */
   struct Node {
     std::pair<const Key, Value> mValue; // The actual value stored here
@@ -208,14 +251,29 @@ private:
      */
     Node* mNext[1];
 
-    /* Constructor sets up the value to the specified key/value pair. */
-    Node(const Key& key, const Value& value, size_t level);
+    /* Constructor sets up the value from the key and whatever arguments
+     * construct a Value.
+     */
+    template <typename... Args>
+    Node(size_t level, const Key& key, Args&&... args);
 
-    /* operator new overallocates storage for the entry. */
-    void* operator new (size_t size, size_t numPointers);
+    /* operator new overallocates storage for the entry, taking the memory
+     * from the given allocator.
+     */
+    void* operator new (size_t size, size_t numPointers, NodeAllocator& alloc);
 
     /* Matching operator delete exists in case an exception is thrown. */
-    void operator delete (void* memory);
+    void operator delete (void* memory, size_t numPointers, NodeAllocator& alloc);
+
+    /* Destroys a node and hands its memory back to the allocator. */
+    static void destroy(Node* node, NodeAllocator& alloc);
+
+    /* The number of NodeUnits making up a node with this many pointers. */
+    static size_t unitsFor(size_t numPointers);
+  };
+
+  struct NodeUnit {
+    alignas(Node) unsigned char mBytes[alignof(Node)];
   };
 
   /* A constant controlling the maximum number of pointers to store in any
@@ -223,6 +281,9 @@ private:
    */
   static const size_t kMaxLevel = 32; // Enough space to hold 2^32 elements
 
+  /* The seed used when none is given.  Any nonzero value will do. */
+  static const uint64_t kDefaultSeed = 0x9E3779B97F4A7C15ULL;
+
   /* An array of kMaxLevel pointers to entries in the list, all initially
    * set to NULL.
    */
@@ -240,6 +301,14 @@ private:
   /* The number of elements in the list. */
   size_t mSize;
 
+  /* The allocator supplying memory for the nodes. */
+  NodeAllocator mAlloc;
+
+  /* State of the xorshift64* generator used to pick node levels.  It is
+   * never zero.
+   */
+  uint64_t mRandomState;
+
   /* A utility base class for iterator and const_iterator which actually
    * supplies all of the logic necessary for the two to work together.  The
    * parameters are the derived type, the type of a pointer being visited, and
@@ -275,40 +344,50 @@ private:
   Node* findNodeAndPredecessors(const Key& key, Node** predecessors[]);
 
   /* A utility function to pick a random level for a node. */
-  static size_t chooseRandomLevel();
+  size_t chooseRandomLevel();
+
+  /* Steps the generator and returns 64 fresh random bits. */
+  uint64_t nextRandom();
 };
 
 /* Comparison operators for ReverseSkiplists. */
-template <typename Key, typename Value, typename Comparator>
-bool operator<  (const ReverseSkiplist<Key, Value, Comparator>& lhs,
-                 const ReverseSkiplist<Key, Value, Comparator>& rhs);
-template <typename Key, typename Value, typename Comparator>
-bool operator<= (const ReverseSkiplist<Key, Value, Comparator>& lhs,
-                 const ReverseSkiplist<Key, Value, Comparator>& rhs);
-template <typename Key, typename Value, typename Comparator>
-bool operator== (const ReverseSkiplist<Key, Value, Comparator>& lhs,
-                 const ReverseSkiplist<Key, Value, Comparator>& rhs);
-template <typename Key, typename Value, typename Comparator>
-bool operator!= (const ReverseSkiplist<Key, Value, Comparator>& lhs,
-                 const ReverseSkiplist<Key, Value, Comparator>& rhs);
-template <typename Key, typename Value, typename Comparator>
-bool operator>= (const ReverseSkiplist<Key, Value, Comparator>& lhs,
-                 const ReverseSkiplist<Key, Value, Comparator>& rhs);
-template <typename Key, typename Value, typename Comparator>
-bool operator>  (const ReverseSkiplist<Key, Value, Comparator>& lhs,
-                 const ReverseSkiplist<Key, Value, Comparator>& rhs);
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+bool operator<  (const ReverseSkiplist<Key, Value, Comparator, Allocator>& lhs,
+                 const ReverseSkiplist<Key, Value, Comparator, Allocator>& rhs);
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+bool operator<= (const ReverseSkiplist<Key, Value, Comparator, Allocator>& lhs,
+                 const ReverseSkiplist<Key, Value, Comparator, Allocator>& rhs);
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+bool operator== (const ReverseSkiplist<Key, Value, Comparator, Allocator>& lhs,
+                 const ReverseSkiplist<Key, Value, Comparator, Allocator>& rhs);
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+bool operator!= (const ReverseSkiplist<Key, Value, Comparator, Allocator>& lhs,
+                 const ReverseSkiplist<Key, Value, Comparator, Allocator>& rhs);
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+bool operator>= (const ReverseSkiplist<Key, Value, Comparator, Allocator>& lhs,
+                 const ReverseSkiplist<Key, Value, Comparator, Allocator>& rhs);
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+bool operator>  (const ReverseSkiplist<Key, Value, Comparator, Allocator>& lhs,
+                 const ReverseSkiplist<Key, Value, Comparator, Allocator>& rhs);
 
 /* * * * * Implementation Below This Point * * * * */
 
 /* Definition of the IteratorBase type, which is used to provide a common
  * implementation for iterator and const_iterator.
  */
-template <typename Key, typename Value, typename Comparator>
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
 template <typename DerivedType, typename Pointer, typename Reference>
-class ReverseSkiplist<Key, Value, Comparator>::IteratorBase {
+class ReverseSkiplist<Key, Value, Comparator, Allocator>::IteratorBase {
 public:
   /* Utility typedef to talk about nodes. */
-  typedef typename ReverseSkiplist<Key, Value, Comparator>::Node Node;
+  typedef typename ReverseSkiplist<Key, Value, Comparator, Allocator>::Node Node;
 
   /* Advance operators just construct derived type instances of the proper
    * type, then advance them.
@@ -378,17 +457,22 @@ protected:
 
 /* iterator and const_iterator implementations work by deriving off of
  * IteratorBase, passing in parameters that make all the operators work.
- * Additionally, we inherit from std::iterator to import all the necessary
- * typedefs to qualify as an iterator.
+ * Additionally, each declares the typedefs needed to qualify as an
+ * iterator, which std::iterator used to supply before it was deprecated.
  */
-template <typename Key, typename Value, typename Comparator>
-class ReverseSkiplist<Key, Value, Comparator>::iterator:
-  public std::iterator< std::forward_iterator_tag,
-                        std::pair<const Key, Value> >,
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+class ReverseSkiplist<Key, Value, Comparator, Allocator>::iterator:
   public IteratorBase<iterator,                       // Our type
                       std::pair<const Key, Value>*,   // Reference type
                       std::pair<const Key, Value>&> { // Pointer type
 public:
+  typedef std::forward_iterator_tag    iterator_category;
+  typedef std::pair<const Key, Value>  value_type;
+  typedef std::ptrdiff_t               difference_type;
+  typedef std::pair<const Key, Value>* pointer;
+  typedef std::pair<const Key, Value>& reference;
+
   /* Default constructor forwards NULL to base implicity. */
   iterator() {
     // Nothing to do here.
@@ -401,7 +485,7 @@ private:
    * argument to the base type.  This line is absolutely awful because the
    * type of the base is so complex.
    */
-  iterator(typename ReverseSkiplist<Key, Value, Comparator>::Node* node) :
+  iterator(typename ReverseSkiplist<Key, Value, Comparator, Allocator>::Node* node) :
     IteratorBase<iterator,
                  std::pair<const Key, Value>*,
                  std::pair<const Key, Value>&>(node) {
@@ -418,14 +502,19 @@ private:
 };
 
 /* Same as above, but with const added in. */
-template <typename Key, typename Value, typename Comparator>
-class ReverseSkiplist<Key, Value, Comparator>::const_iterator:
-  public std::iterator< std::forward_iterator_tag,
-                        const std::pair<const Key, Value> >,
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+class ReverseSkiplist<Key, Value, Comparator, Allocator>::const_iterator:
   public IteratorBase<const_iterator,                       // Our type
                       const std::pair<const Key, Value>*,   // Reference type
                       const std::pair<const Key, Value>&> { // Pointer type
 public:
+  typedef std::forward_iterator_tag          iterator_category;
+  typedef const std::pair<const Key, Value>  value_type;
+  typedef std::ptrdiff_t                     difference_type;
+  typedef const std::pair<const Key, Value>* pointer;
+  typedef const std::pair<const Key, Value>& reference;
+
   /* Default constructor forwards NULL to base implicity. */
   const_iterator() {
     // Nothing to do here.
@@ -445,7 +534,7 @@ public:
 
 private:
   /* See iterator implementation for details about what this does. */
-  const_iterator(typename ReverseSkiplist<Key, Value, Comparator>::Node* node) :
+  const_iterator(typename ReverseSkiplist<Key, Value, Comparator, Allocator>::Node* node) :
     IteratorBase<const_iterator,
                  const std::pair<const Key, Value>*,
                  const std::pair<const Key, Value>&>(node) {
@@ -459,22 +548,38 @@ private:
 /**** ReverseSkiplist::Node Implementation. ****/
 
 /* Constructor initializes the key/value pair using its arguments. */
-template <typename Key, typename Value, typename Comparator>
-ReverseSkiplist<Key, Value, Comparator>::Node::Node(const Key& key, const Value& value, size_t level)
-  : mValue(key, value), mLevel(level) {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+template <typename... Args>
+ReverseSkiplist<Key, Value, Comparator, Allocator>::Node::Node(size_t level, const Key& key, Args&&... args)
+  : mValue(std::piecewise_construct, std::forward_as_tuple(key),
+           std::forward_as_tuple(std::forward<Args>(args)...)),
+    mLevel(level) {
   // Handled in initializer list
 }
 
-/* operator new overallocates space so that there are sufficiently many
- * pointers available off the end of the struct.
+/* unitsFor rounds the size of a node with the given number of pointers up
+ * to a whole number of NodeUnits.
  */
-template <typename Key, typename Value, typename Comparator>
-void* ReverseSkiplist<Key, Value, Comparator>::Node::operator new (size_t size, size_t numPointers) {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+size_t ReverseSkiplist<Key, Value, Comparator, Allocator>::Node::unitsFor(size_t numPointers) {
   /* The Node itself contains one pointer, so we need to allocate space for
    * numPointers - 1 extra pointers.
    */
+  const size_t spaceNeeded = sizeof(Node) + (numPointers - 1) * sizeof(Node*);
+  return (spaceNeeded + sizeof(NodeUnit) - 1) / sizeof(NodeUnit);
+}
+
+/* operator new overallocates space so that there are sufficiently many
+ * pointers available off the end of the struct.
+ */
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+void* ReverseSkiplist<Key, Value, Comparator, Allocator>::Node::operator new (size_t size, size_t numPointers,
+                                      NodeAllocator& alloc) {
   const size_t spaceNeeded = size + (numPointers - 1) * sizeof(Node*);
-  void* result = ::operator new(spaceNeeded);
+  void* result = std::allocator_traits<NodeAllocator>::allocate(alloc, unitsFor(numPointers));
 
   /* Zero out the memory; we want to ensure that the pointers are zeroed
    * before continuing.
@@ -488,17 +593,33 @@ void* ReverseSkiplist<Key, Value, Comparator>::Node::operator new (size_t size,
  * exception.  This should never happen, but we should put this here anyway
  * in case a future version ends up throwing.
  */
-template <typename Key, typename Value, typename Comparator>
-void ReverseSkiplist<Key, Value, Comparator>::Node::operator delete(void* memory) {
-  /* This can be handled using the default operator delete implementation. */
-  ::operator delete(memory);
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+void ReverseSkiplist<Key, Value, Comparator, Allocator>::Node::operator delete(void* memory, size_t numPointers,
+                                         NodeAllocator& alloc) {
+  std::allocator_traits<NodeAllocator>::deallocate(alloc, static_cast<NodeUnit*>(memory),
+                                                   unitsFor(numPointers));
+}
+
+/* destroy runs the destructor by hand, since a plain delete expression can't
+ * pass along the level and the allocator, then frees the memory.
+ */
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+void ReverseSkiplist<Key, Value, Comparator, Allocator>::Node::destroy(Node* node, NodeAllocator& alloc) {
+  const size_t level = node->mLevel;
+  node->~Node();
+  Node::operator delete(node, level, alloc);
 }
 
 /**** ReverseSkiplist Implementation ****/
 
 /* Constructor zeros out relevant fields. */
-template <typename Key, typename Value, typename Comparator>
-ReverseSkiplist<Key, Value, Comparator>::ReverseSkiplist(Comparator comp) : mComp(comp) {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+ReverseSkiplist<Key, Value, Comparator, Allocator>::ReverseSkiplist(Comparator comp, const Allocator& alloc,
+                                                                    uint64_t seed)
+  : mComp(comp), mAlloc(alloc), mRandomState(seed != 0 ? seed : kDefaultSeed) {
   /* Set all of the node pointers to NULL. */
   std::memset(mList, 0, sizeof(mList));
 
@@ -510,8 +631,9 @@ ReverseSkiplist<Key, Value, Comparator>::ReverseSkiplist(Comparator comp) : mCom
 }
 
 /* Destructor walks across the ReverseSkiplist, deleting elements. */
-template <typename Key, typename Value, typename Comparator>
-ReverseSkiplist<Key, Value, Comparator>::~ReverseSkiplist() {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+ReverseSkiplist<Key, Value, Comparator, Allocator>::~ReverseSkiplist() {
   /* Walk across the bottom of the list. */
   Node* curr = mList[0];
   while (curr != NULL) {
@@ -521,55 +643,62 @@ ReverseSkiplist<Key, Value, Comparator>::~ReverseSkiplist() {
     Node* next = curr->mNext[0];
 
     /* Free memory, then advance to the next location. */
-    delete curr;
+    Node::destroy(curr, mAlloc);
     curr = next;
   }
 }
 
 /* begin hands back a (const_)iterator initialized to the head of the list. */
-template <typename Key, typename Value, typename Comparator>
-typename ReverseSkiplist<Key, Value, Comparator>::iterator
-ReverseSkiplist<Key, Value, Comparator>::begin() {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+typename ReverseSkiplist<Key, Value, Comparator, Allocator>::iterator
+ReverseSkiplist<Key, Value, Comparator, Allocator>::begin() {
   return iterator(mList[0]); // Scan bottom row
 }
-template <typename Key, typename Value, typename Comparator>
-typename ReverseSkiplist<Key, Value, Comparator>::const_iterator
-ReverseSkiplist<Key, Value, Comparator>::begin() const {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+typename ReverseSkiplist<Key, Value, Comparator, Allocator>::const_iterator
+ReverseSkiplist<Key, Value, Comparator, Allocator>::begin() const {
   return const_iterator(mList[0]); // Scan bottom row
 }
 
 /* end hands back a (const_)iterator initialized to NULL, which comes one step
  * past the end of the list.
  */
-template <typename Key, typename Value, typename Comparator>
-typename ReverseSkiplist<Key, Value, Comparator>::iterator
-ReverseSkiplist<Key, Value, Comparator>::end() {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+typename ReverseSkiplist<Key, Value, Comparator, Allocator>::iterator
+ReverseSkiplist<Key, Value, Comparator, Allocator>::end() {
   return iterator(NULL);
 }
-template <typename Key, typename Value, typename Comparator>
-typename ReverseSkiplist<Key, Value, Comparator>::const_iterator
-ReverseSkiplist<Key, Value, Comparator>::end() const {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+typename ReverseSkiplist<Key, Value, Comparator, Allocator>::const_iterator
+ReverseSkiplist<Key, Value, Comparator, Allocator>::end() const {
   return const_iterator(NULL);
 }
 
 /* We cache the size to simplify this implementation. */
-template <typename Key, typename Value, typename Comparator>
-size_t ReverseSkiplist<Key, Value, Comparator>::size() const {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+size_t ReverseSkiplist<Key, Value, Comparator, Allocator>::size() const {
   return mSize;
 }
 
 /* Checking for emptiness just checks whether the stored size is zero. */
-template <typename Key, typename Value, typename Comparator>
-bool ReverseSkiplist<Key, Value, Comparator>::empty() const {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+bool ReverseSkiplist<Key, Value, Comparator, Allocator>::empty() const {
   return size() == 0;
 }
 
 /* Checking whether an element exists involves scanning over the ReverseSkiplist
  * level-by-level looking for the key.
  */
-template <typename Key, typename Value, typename Comparator>
-typename ReverseSkiplist<Key, Value, Comparator>::Node*
-ReverseSkiplist<Key, Value, Comparator>::findNode(const Key& key) const {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+typename ReverseSkiplist<Key, Value, Comparator, Allocator>::Node*
+ReverseSkiplist<Key, Value, Comparator, Allocator>::findNode(const Key& key) const {
   /* At each step, we need to maintain an array of pointers containing
    * possible places to look.  This is initially the ReverseSkiplist's own master
    * list of pointers.
@@ -605,23 +734,26 @@ ReverseSkiplist<Key, Value, Comparator>::findNode(const Key& key) const {
 /* Both versions of find work by calling findNode and then wrapping up the
  * result.
  */
-template <typename Key, typename Value, typename Comparator>
-typename ReverseSkiplist<Key, Value, Comparator>::iterator
-ReverseSkiplist<Key, Value, Comparator>::find(const Key& key) {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+typename ReverseSkiplist<Key, Value, Comparator, Allocator>::iterator
+ReverseSkiplist<Key, Value, Comparator, Allocator>::find(const Key& key) {
   return iterator(findNode(key));
 }
-template <typename Key, typename Value, typename Comparator>
-typename ReverseSkiplist<Key, Value, Comparator>::const_iterator
-ReverseSkiplist<Key, Value, Comparator>::find(const Key& key) const {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+typename ReverseSkiplist<Key, Value, Comparator, Allocator>::const_iterator
+ReverseSkiplist<Key, Value, Comparator, Allocator>::find(const Key& key) const {
   return const_iterator(findNode(key));
 }
 
 /* Checking whether an element exists involves scanning over the ReverseSkiplist
  * level-by-level looking for the key.
  */
-template <typename Key, typename Value, typename Comparator>
-typename ReverseSkiplist<Key, Value, Comparator>::Node*
-ReverseSkiplist<Key, Value, Comparator>::findNodeAndPredecessors(const Key& key,
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+typename ReverseSkiplist<Key, Value, Comparator, Allocator>::Node*
+ReverseSkiplist<Key, Value, Comparator, Allocator>::findNodeAndPredecessors(const Key& key,
                                                           Node** predecessors[]) {
   /* At each step, we need to maintain an array of pointers containing
    * possible places to look.  This is initially the ReverseSkiplist's own master
@@ -657,36 +789,57 @@ ReverseSkiplist<Key, Value, Comparator>::findNodeAndPredecessors(const Key& key,
   return NULL;
 }
 
+/* nextRandom advances the xorshift64* generator (Marsaglia's xorshift
+ * followed by a multiply to scramble the low bits) and returns its output.
+ * Each list has its own generator, so the shape of the list depends only on
+ * its seed and the operations performed on it, and no lock is taken as
+ * rand() would.
+ */
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+uint64_t ReverseSkiplist<Key, Value, Comparator, Allocator>::nextRandom() {
+  mRandomState ^= mRandomState >> 12;
+  mRandomState ^= mRandomState << 25;
+  mRandomState ^= mRandomState >> 27;
+  return mRandomState * 0x2545F4914F6CDD1DULL;
+}
+
 /* Picks a random level for a node by advancing upward and upward with
  * uniform probability.
  */
-template <typename Key, typename Value, typename Comparator>
-size_t ReverseSkiplist<Key, Value, Comparator>::chooseRandomLevel() {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+size_t ReverseSkiplist<Key, Value, Comparator, Allocator>::chooseRandomLevel() {
   /* We advance to a new level with probability 1/4 at each point, as suggested
-   * by the original paper.  To do this with a minimum of floating-point
-   * computations, we compute RAND_MAX / 4 and then go up a level every time
-   * rand() is no greater than this value.
+   * by the original paper.  Each bit of a random word is zero with
+   * probability 1/2, so each pair of trailing zero bits is one promotion, and
+   * the whole level comes from a single word: one plus half the number of
+   * trailing zeros.  A zero word has no lowest set bit and gets the top level.
    */
-  static const int kLevelProbability = RAND_MAX / 4;
-
-  /* In the worst case, we have one level of pointers. */
-  size_t result = 1;
+  const uint64_t bits = nextRandom();
+  if (bits == 0)
+    return kMaxLevel;
 
-  /* Loop while we keep choosing to promote and while the level is no larger
-   * than the max level.
-   */
-  while (rand() < kLevelProbability && result < kMaxLevel)
-    ++result;
+  const size_t level = 1 + __builtin_ctzll(bits) / 2;
+  return level < kMaxLevel ? level : kMaxLevel;
+}
 
-  return result;
+/* Insertion just copies the value in with emplace. */
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+std::pair<typename ReverseSkiplist<Key, Value, Comparator, Allocator>::iterator, bool>
+ReverseSkiplist<Key, Value, Comparator, Allocator>::insert(const Key& key, const Value& value) {
+  return emplace(key, value);
 }
 
-/* Insertion into the ReverseSkiplist works by building up the predecessors, then
+/* Emplacement into the ReverseSkiplist works by building up the predecessors, then
  * inserting the new node with some arbitrary height at the indicated spot.
  */
-template <typename Key, typename Value, typename Comparator>
-std::pair<typename ReverseSkiplist<Key, Value, Comparator>::iterator, bool>
-ReverseSkiplist<Key, Value, Comparator>::insert(const Key& key, const Value& value) {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+template <typename... Args>
+std::pair<typename ReverseSkiplist<Key, Value, Comparator, Allocator>::iterator, bool>
+ReverseSkiplist<Key, Value, Comparator, Allocator>::emplace(const Key& key, Args&&... args) {
   /* Begin by calling the find predecessors function to determine what comes
    * right before this node.
    */
@@ -704,10 +857,11 @@ ReverseSkiplist<Key, Value, Comparator>::insert(const Key& key, const Value& val
    */
   const size_t level = chooseRandomLevel();
 
-  /* Create the node object to hold the key/value pair.  We pass the level as
-   * an argument to new to ensure space exists for the pointers.
+  /* Create the node object to hold the key/value pair, building the value in
+   * place.  We pass the level as an argument to new to ensure space exists
+   * for the pointers.
    */
-  Node* node = new (level) Node(key, value, level);
+  Node* node = new (level, mAlloc) Node(level, key, std::forward<Args>(args)...);
 
   /* To splice this node into the list, we'll make all of its outgoing
    * pointers on each of its levels point to the location the predecessor used
@@ -747,8 +901,9 @@ ReverseSkiplist<Key, Value, Comparator>::insert(const Key& key, const Value& val
 /* The const version of at uses findNode to locate the element, then complains
  * if nothing was found.
  */
-template <typename Key, typename Value, typename Comparator>
-const Value& ReverseSkiplist<Key, Value, Comparator>::at(const Key& key) const {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+const Value& ReverseSkiplist<Key, Value, Comparator, Allocator>::at(const Key& key) const {
   /* Look up the node and return its value if found. */
   if (Node* node = findNode(key))
     return node->mValue.second;
@@ -758,24 +913,27 @@ const Value& ReverseSkiplist<Key, Value, Comparator>::at(const Key& key) const {
 /* Non-const version implemented in terms of const version using the
  * const_cast/static_cast trick.
  */
-template <typename Key, typename Value, typename Comparator>
-Value& ReverseSkiplist<Key, Value, Comparator>::at(const Key& key) {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+Value& ReverseSkiplist<Key, Value, Comparator, Allocator>::at(const Key& key) {
   return const_cast<Value&>(static_cast<const ReverseSkiplist*>(this)->at(key));
 }
 
 /* operator[] implemented by inserting a dummy element with insert, then using
  * the returned iterator to extract the value.
  */
-template <typename Key, typename Value, typename Comparator>
-Value& ReverseSkiplist<Key, Value, Comparator>::operator[] (const Key& key) {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+Value& ReverseSkiplist<Key, Value, Comparator, Allocator>::operator[] (const Key& key) {
   return insert(key, Value()).first->second;
 }
 
 /* Erasing an element works by locating its predecessors, then wiring them
  * around the element to be deleted.
  */
-template <typename Key, typename Value, typename Comparator>
-bool ReverseSkiplist<Key, Value, Comparator>::erase(const Key& key) {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+bool ReverseSkiplist<Key, Value, Comparator, Allocator>::erase(const Key& key) {
   /* Begin by calling the find predecessors function to determine what comes
    * right before this node.
    */
@@ -794,7 +952,7 @@ bool ReverseSkiplist<Key, Value, Comparator>::erase(const Key& key) {
     *predecessors[i] = entry->mNext[i];
 
   /* Actually delete the node to ensure that the memory isn't leaked. */
-  delete entry;
+  Node::destroy(entry, mAlloc);
 
   /* Determine if the level of the list needs to be updated.  We do this by
    * marching downward across the master pointer table, decrementing the count
@@ -815,8 +973,12 @@ bool ReverseSkiplist<Key, Value, Comparator>::erase(const Key& key) {
  * efficient way to accomplish this, but it's simple to implement and avoids
  * all sorts of awful pointer wrangling.
  */
-template <typename Key, typename Value, typename Comparator>
-ReverseSkiplist<Key, Value, Comparator>::ReverseSkiplist(const ReverseSkiplist& other) : mComp(other.mComp) {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+ReverseSkiplist<Key, Value, Comparator, Allocator>::ReverseSkiplist(const ReverseSkiplist& other)
+  : mComp(other.mComp),
+    mAlloc(std::allocator_traits<NodeAllocator>::select_on_container_copy_construction(other.mAlloc)),
+    mRandomState(other.mRandomState) {
   /* Clear out the pointers, size fields, etc. */
   std::memset(mList, 0, sizeof(mList));
   mHighestLevel = mSize = 0;
@@ -827,19 +989,51 @@ ReverseSkiplist<Key, Value, Comparator>::ReverseSkiplist(const ReverseSkiplist&
 }
 
 /* Assignment operator implemented using the copy-and-swap approach. */
-template <typename Key, typename Value, typename Comparator>
-ReverseSkiplist<Key, Value, Comparator>&
-ReverseSkiplist<Key, Value, Comparator>::operator= (const ReverseSkiplist& other) {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+ReverseSkiplist<Key, Value, Comparator, Allocator>&
+ReverseSkiplist<Key, Value, Comparator, Allocator>::operator= (const ReverseSkiplist& other) {
   ReverseSkiplist clone = other;
   clone.swap(*this);
   return *this;
 }
 
+/* Move constructor steals the other list's pointer table and leaves the
+ * other list empty, so that no nodes are copied.
+ */
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+ReverseSkiplist<Key, Value, Comparator, Allocator>::ReverseSkiplist(ReverseSkiplist&& other) noexcept
+  : mComp(std::move(other.mComp)), mAlloc(std::move(other.mAlloc)),
+    mRandomState(other.mRandomState) {
+  /* Take over the nodes. */
+  std::memcpy(mList, other.mList, sizeof(mList));
+  mHighestLevel = other.mHighestLevel;
+  mSize = other.mSize;
+
+  /* Reset the other list so that its destructor frees nothing. */
+  std::memset(other.mList, 0, sizeof(other.mList));
+  other.mHighestLevel = other.mSize = 0;
+}
+
+/* Move assignment moves the other list into a temporary and swaps with it, so
+ * the old contents are freed when the temporary goes away.
+ */
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+ReverseSkiplist<Key, Value, Comparator, Allocator>&
+ReverseSkiplist<Key, Value, Comparator, Allocator>::operator= (ReverseSkiplist&& other) noexcept {
+  ReverseSkiplist clone(std::move(other));
+  clone.swap(*this);
+  return *this;
+}
+
 /* swap just uses the standard swap function to exchange the contents of this
  * ReverseSkiplist and the other ReverseSkiplist.
  */
-template <typename Key, typename Value, typename Comparator>
-void ReverseSkiplist<Key, Value, Comparator>::swap(ReverseSkiplist& other) {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+void ReverseSkiplist<Key, Value, Comparator, Allocator>::swap(ReverseSkiplist& other) {
   /* Swap pointers. */
   for (size_t i = 0; i < kMaxLevel; ++i)
     std::swap(mList[i], other.mList[i]);
@@ -852,43 +1046,55 @@ void ReverseSkiplist<Key, Value, Comparator>::swap(ReverseSkiplist& other) {
    * functions.
    */
   std::swap(mComp, other.mComp);
+
+  /* The nodes must go back to the allocator they came from, and each list
+   * keeps drawing levels from where its generator left off.
+   */
+  std::swap(mAlloc, other.mAlloc);
+  std::swap(mRandomState, other.mRandomState);
 }
 
 /* Comparison operators == and < use the standard STL algorithms. */
-template <typename Key, typename Value, typename Comparator>
-bool operator<  (const ReverseSkiplist<Key, Value, Comparator>& lhs,
-                 const ReverseSkiplist<Key, Value, Comparator>& rhs) {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+bool operator<  (const ReverseSkiplist<Key, Value, Comparator, Allocator>& lhs,
+                 const ReverseSkiplist<Key, Value, Comparator, Allocator>& rhs) {
   return std::lexicographical_compare(lhs.begin(), lhs.end(),
                                       rhs.begin(), rhs.end());
 }
-template <typename Key, typename Value, typename Comparator>
-bool operator== (const ReverseSkiplist<Key, Value, Comparator>& lhs,
-                 const ReverseSkiplist<Key, Value, Comparator>& rhs) {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+bool operator== (const ReverseSkiplist<Key, Value, Comparator, Allocator>& lhs,
+                 const ReverseSkiplist<Key, Value, Comparator, Allocator>& rhs) {
   return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(),
                                                 rhs.begin());
 }
 
 /* Remaining comparisons implemented in terms of the above comparisons. */
-template <typename Key, typename Value, typename Comparator>
-bool operator<= (const ReverseSkiplist<Key, Value, Comparator>& lhs,
-                 const ReverseSkiplist<Key, Value, Comparator>& rhs) {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+bool operator<= (const ReverseSkiplist<Key, Value, Comparator, Allocator>& lhs,
+                 const ReverseSkiplist<Key, Value, Comparator, Allocator>& rhs) {
   /* x <= y   iff !(x > y)   iff !(y < x) */
   return !(rhs < lhs);
 }
-template <typename Key, typename Value, typename Comparator>
-bool operator!= (const ReverseSkiplist<Key, Value, Comparator>& lhs,
-                 const ReverseSkiplist<Key, Value, Comparator>& rhs) {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+bool operator!= (const ReverseSkiplist<Key, Value, Comparator, Allocator>& lhs,
+                 const ReverseSkiplist<Key, Value, Comparator, Allocator>& rhs) {
   return !(lhs == rhs);
 }
-template <typename Key, typename Value, typename Comparator>
-bool operator>= (const ReverseSkiplist<Key, Value, Comparator>& lhs,
-                 const ReverseSkiplist<Key, Value, Comparator>& rhs) {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+bool operator>= (const ReverseSkiplist<Key, Value, Comparator, Allocator>& lhs,
+                 const ReverseSkiplist<Key, Value, Comparator, Allocator>& rhs) {
   /* x >= y   iff !(x < y) */
   return !(lhs < rhs);
 }
-template <typename Key, typename Value, typename Comparator>
-bool operator>  (const ReverseSkiplist<Key, Value, Comparator>& lhs,
-                 const ReverseSkiplist<Key, Value, Comparator>& rhs) {
+template <typename Key, typename Value, typename Comparator,
+          typename Allocator>
+bool operator>  (const ReverseSkiplist<Key, Value, Comparator, Allocator>& lhs,
+                 const ReverseSkiplist<Key, Value, Comparator, Allocator>& rhs) {
   /* x > y iff y < x */
   return rhs < lhs;
 }
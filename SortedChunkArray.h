@@ -0,0 +1,270 @@
+#ifndef Sorted_Chunk_Array_Included
+#define Sorted_Chunk_Array_Included
+
+#include <vector>
+#include <memory>       /* For std::allocator, std::allocator_traits */
+#include <algorithm>
+#include <functional>   /* For std::less */
+#include <iterator>     /* For std::forward_iterator_tag */
+#include <cstddef>
+
+/* A set of values ordered by a key taken from each value, kept as
+   sorted contiguous arrays, for the small per-node interval lists of
+   DynamicIntervalTree. Only the values are stored; KeyOfValue computes
+   the key of a value whenever it is compared. Up to
+   kInlineSize entries are stored inside the object itself, with no
+   allocation at all. Past that the entries move into a list of chunks,
+   each a vector of at most kChunkSize entries, in order: like the leaves
+   of a B+ tree, with the chunk list standing in for the inner nodes. A
+   lookup is a binary search over the chunks and one within a chunk,
+   and iteration reads each chunk front to back.
+
+   As with Skiplist, keys are unique: inserting a value whose key is
+   already present leaves the set unchanged. Value must be default
+   constructible and copyable. Iterators are invalidated by any insert
+   or erase. Chunks, and the list of them, come from Allocator. */
+template <typename Key, typename Value, typename KeyOfValue,
+          typename Comparator = std::less<Key>, typename Allocator = std::allocator<Value> >
+class SortedChunkArray
+{
+  public:
+    typedef Value value_type;
+
+    class iterator;
+    typedef iterator const_iterator;
+
+    SortedChunkArray () : total (0) {}
+    explicit SortedChunkArray (const Allocator& allocator) : chunks (allocator), total (0) {}
+
+    size_t size () const { return total; }
+    bool empty () const { return total == 0; }
+
+    /* Adds value unless its key is already present. Returns whether
+       anything was inserted. */
+    bool insert (const Value& value);
+
+    /* Removes the value with this key, if any. Returns whether a value
+       was removed. */
+    bool erase (const Key& key);
+
+    iterator begin () const;
+    iterator end () const { return iterator (this, chunks.size (), nullptr, nullptr); }
+
+  private:
+    typedef std::vector<value_type, Allocator> Chunk;
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Chunk> ChunkListAllocator;
+
+    static const size_t kInlineSize = 8;
+    static const size_t kChunkSize = 32;
+
+    /* All the entries while there are no chunks, at most kInlineSize */
+    value_type items[kInlineSize];
+
+    /* Chunks in key order, each holding at least one entry. Every chunk
+       is made with room for kChunkSize entries and never grows past it,
+       so all chunks are blocks of one size, which a pool can recycle
+       between nodes. */
+    std::vector<Chunk, ChunkListAllocator> chunks;
+
+    size_t total;
+
+    static bool less (const Key& a, const Key& b) { return Comparator () (a, b); }
+    static Key keyOf (const Value& value) { return KeyOfValue () (value); }
+
+    /* A chunk holding a copy of [first, last) */
+    Chunk makeChunk (const value_type* first, const value_type* last) const
+    {
+      Chunk chunk ((Allocator (chunks.get_allocator ())));
+      chunk.reserve (kChunkSize);
+      chunk.assign (first, last);
+      return chunk;
+    }
+
+    /* Index of the first entry in [first, first + count) not less than key */
+    size_t lowerBound (const value_type* first, size_t count, const Key& key) const
+    {
+      size_t lo = 0;
+      while (count > 0) {
+        size_t half = count / 2;
+        if (less (keyOf (first[lo + half]), key)) {
+          lo += half + 1;
+          count -= half + 1;
+        }
+        else {
+          count = half;
+        }
+      }
+      return lo;
+    }
+
+    /* The chunk that holds key or would hold it if it were inserted: the
+       first whose last key is not less than key, else the last chunk */
+    size_t findChunk (const Key& key) const
+    {
+      size_t lo = 0, count = chunks.size ();
+      while (count > 0) {
+        size_t half = count / 2;
+        if (less (keyOf (chunks[lo + half].back ()), key)) {
+          lo += half + 1;
+          count -= half + 1;
+        }
+        else {
+          count = half;
+        }
+      }
+      return std::min (lo, chunks.size () - 1);
+    }
+};
+
+/* Forward iterator over the entries in key order */
+template <typename Key, typename Value, typename KeyOfValue, typename Comparator, typename Allocator>
+class SortedChunkArray<Key, Value, KeyOfValue, Comparator, Allocator>::iterator
+{
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef typename SortedChunkArray::value_type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const value_type* pointer;
+    typedef const value_type& reference;
+
+    iterator () : owner (nullptr), chunk (0), current (nullptr), run_end (nullptr) {}
+
+    reference operator* () const { return *current; }
+    pointer operator-> () const { return current; }
+
+    iterator& operator++ ()
+    {
+      if (++current == run_end) {
+        if (++chunk < owner->chunks.size ()) {
+          current = owner->chunks[chunk].data ();
+          run_end = current + owner->chunks[chunk].size ();
+        }
+        else {
+          chunk = owner->chunks.size ();
+          current = run_end = nullptr;
+        }
+      }
+      return *this;
+    }
+
+    iterator operator++ (int)
+    {
+      iterator old = *this;
+      ++*this;
+      return old;
+    }
+
+    bool operator== (const iterator& other) const { return current == other.current; }
+    bool operator!= (const iterator& other) const { return current != other.current; }
+
+  private:
+    friend class SortedChunkArray;
+
+    iterator (const SortedChunkArray* owner, size_t chunk, const value_type* current,
+              const value_type* run_end)
+      : owner (owner), chunk (chunk), current (current), run_end (run_end) {}
+
+    const SortedChunkArray* owner;
+    size_t chunk;                   /* Chunk being read; 0 for inline entries */
+    const value_type* current;
+    const value_type* run_end;      /* End of the contiguous run being read */
+};
+
+/* * * * * Implementation Below This Point * * * * */
+
+template <typename Key, typename Value, typename KeyOfValue, typename Comparator, typename Allocator>
+typename SortedChunkArray<Key, Value, KeyOfValue, Comparator, Allocator>::iterator
+SortedChunkArray<Key, Value, KeyOfValue, Comparator, Allocator>::begin () const
+{
+  if (total == 0) return end ();
+
+  /* Inline entries read like the only chunk */
+  if (chunks.empty ()) return iterator (this, 0, items, items + total);
+  return iterator (this, 0, chunks[0].data (), chunks[0].data () + chunks[0].size ());
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Comparator, typename Allocator>
+bool
+SortedChunkArray<Key, Value, KeyOfValue, Comparator, Allocator>::insert (const Value& value)
+{
+  Key key = keyOf (value);
+  if (chunks.empty ()) {
+    size_t index = lowerBound (items, total, key);
+    if (index < total && !less (key, keyOf (items[index]))) return false;
+
+    if (total < kInlineSize) {
+      std::copy_backward (items + index, items + total, items + total + 1);
+      items[index] = value;
+      total++;
+      return true;
+    }
+
+    /* Out of inline room; the entries move to a first chunk */
+    chunks.push_back (makeChunk (items, items + total));
+    std::fill (items, items + total, value_type ());
+  }
+
+  size_t c = findChunk (key);
+  size_t index = lowerBound (chunks[c].data (), chunks[c].size (), key);
+  if (index < chunks[c].size () && !less (key, keyOf (chunks[c][index]))) return false;
+
+  /* A full chunk is split in half first */
+  if (chunks[c].size () == kChunkSize) {
+    size_t half = kChunkSize / 2;
+    chunks.insert (chunks.begin () + c + 1,
+                   makeChunk (chunks[c].data () + half, chunks[c].data () + kChunkSize));
+    chunks[c].resize (half);
+    if (index > half) {
+      c++;
+      index -= half;
+    }
+  }
+
+  chunks[c].insert (chunks[c].begin () + index, value);
+  total++;
+  return true;
+}
+
+template <typename Key, typename Value, typename KeyOfValue, typename Comparator, typename Allocator>
+bool
+SortedChunkArray<Key, Value, KeyOfValue, Comparator, Allocator>::erase (const Key& key)
+{
+  if (chunks.empty ()) {
+    size_t index = lowerBound (items, total, key);
+    if (index == total || less (key, keyOf (items[index]))) return false;
+    std::copy (items + index + 1, items + total, items + index);
+    items[--total] = value_type ();
+    return true;
+  }
+
+  size_t c = findChunk (key);
+  size_t index = lowerBound (chunks[c].data (), chunks[c].size (), key);
+  if (index == chunks[c].size () || less (key, keyOf (chunks[c][index]))) return false;
+  chunks[c].erase (chunks[c].begin () + index);
+  total--;
+
+  /* Few enough entries go back inline */
+  if (total <= kInlineSize && chunks.size () == 1) {
+    std::copy (chunks[0].begin (), chunks[0].end (), items);
+    chunks.clear ();
+    chunks.shrink_to_fit ();
+    return true;
+  }
+
+  /* Keep chunks from thinning out: an empty chunk goes, and a chunk that
+     fits into half a chunk together with the next one is merged into it */
+  if (chunks[c].empty ()) {
+    chunks.erase (chunks.begin () + c);
+  }
+  else if (c + 1 < chunks.size () && chunks[c].size () + chunks[c + 1].size () <= kChunkSize / 2) {
+    chunks[c].insert (chunks[c].end (), chunks[c + 1].begin (), chunks[c + 1].end ());
+    chunks.erase (chunks.begin () + c + 1);
+  }
+
+  /* A list of chunks that has shrunk to a quarter of its room gives the
+     rest back, so it can serve a list that is growing */
+  if (chunks.size () * 4 <= chunks.capacity ()) chunks.shrink_to_fit ();
+  return true;
+}
+
+#endif
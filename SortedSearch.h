@@ -0,0 +1,44 @@
+#ifndef Sorted_Search_Included
+#define Sorted_Search_Included
+
+#include <cstddef>
+
+/* Binary searches over a contiguous array of keys in ascending order.
+   Each step halves the range with a conditional move instead of a
+   branch, so the loop runs exactly ceil(log2 (count)) times whatever the
+   keys are, with nothing for the branch predictor to get wrong. Runs of
+   equal keys cost no more than distinct ones. */
+
+/* Returns the index of the first key in keys[0, count) that is not less
+   than value, or count if there is none */
+template <typename Key>
+inline size_t
+branchlessLowerBound (const Key* keys, size_t count, Key value)
+{
+  if (count == 0) return 0;
+  const Key* base = keys;
+  while (count > 1) {
+    size_t half = count / 2;
+    base = (base[half] < value) ? base + half : base;
+    count -= half;
+  }
+  return (base - keys) + (*base < value);
+}
+
+/* Returns the index of the first key in keys[0, count) that is greater
+   than value, or count if there is none */
+template <typename Key>
+inline size_t
+branchlessUpperBound (const Key* keys, size_t count, Key value)
+{
+  if (count == 0) return 0;
+  const Key* base = keys;
+  while (count > 1) {
+    size_t half = count / 2;
+    base = (value < base[half]) ? base : base + half;
+    count -= half;
+  }
+  return (base - keys) + !(value < *base);
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef Storage_Array_Included
+#define Storage_Array_Included
+
+#include <vector>
+#include <cstddef>
+#include <utility>      /* For std::move, std::swap */
+
+/* A fixed-size array that either owns its elements in a std::vector or
+   views elements owned by someone else, such as the pages of a mapped
+   file. Readers cannot tell the two apart. Only owning arrays may be
+   resized or written to; a view is read-only, and its memory must
+   outlive it. Copying always produces an owning array. */
+template <typename T>
+class StorageArray
+{
+  public:
+    StorageArray () : items (nullptr), count (0) {}
+
+    StorageArray (const std::vector<T>& values) : owned (values) { sync (); }
+
+    StorageArray (const StorageArray& other) : owned (other.begin (), other.end ()) { sync (); }
+
+    StorageArray (StorageArray&& other) : owned (std::move (other.owned)),
+                                          items (other.items), count (other.count)
+    {
+      other.items = nullptr;
+      other.count = 0;
+    }
+
+    StorageArray& operator= (StorageArray other)
+    {
+      owned.swap (other.owned);
+      std::swap (items, other.items);
+      std::swap (count, other.count);
+      return *this;
+    }
+
+    /* Resizes an owning array, dropping any view */
+    void resize (size_t size)
+    {
+      owned.resize (size);
+      sync ();
+    }
+
+    /* Makes this array a read-only view of size elements at 'data' */
+    void attach (const T* data, size_t size)
+    {
+      std::vector<T> ().swap (owned);
+      items = const_cast<T*> (data);
+      count = size;
+    }
+
+    size_t size () const { return count; }
+    bool empty () const { return count == 0; }
+
+    T& operator[] (size_t i) { return items[i]; }
+    const T& operator[] (size_t i) const { return items[i]; }
+
+    T* data () { return items; }
+    const T* data () const { return items; }
+    T* begin () { return items; }
+    T* end () { return items + count; }
+    const T* begin () const { return items; }
+    const T* end () const { return items + count; }
+
+  private:
+    void sync ()
+    {
+      items = owned.data ();
+      count = owned.size ();
+    }
+
+    std::vector<T> owned;
+    T* items;      /* First element, in 'owned' or in foreign memory */
+    size_t count;
+};
+
+#endif
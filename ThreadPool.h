@@ -0,0 +1,168 @@
+#ifndef Thread_Pool_Included
+#define Thread_Pool_Included
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* A fixed set of worker threads running tasks from a shared queue.
+   Threads waiting on a TaskGroup run queued tasks themselves and only
+   block once the queue is empty, so nested fork-join work cannot
+   deadlock the pool and the waiting thread adds to its parallelism. */
+class ThreadPool
+{
+  public:
+    /* Starts numWorkers threads. A pool with no workers is valid: its
+       tasks are then run by whichever thread waits for them. */
+    explicit ThreadPool (unsigned numWorkers) : stopping (false)
+    {
+      for (unsigned i = 0; i < numWorkers; i++) {
+        workers.push_back (std::thread ([this] () { workerLoop (); }));
+      }
+    }
+
+    ~ThreadPool ()
+    {
+      {
+        std::lock_guard<std::mutex> lock (mutex);
+        stopping = true;
+      }
+      available.notify_all ();
+      for (unsigned i = 0; i < workers.size (); i++) {
+        workers[i].join ();
+      }
+    }
+
+    /* Number of worker threads, not counting threads that help out */
+    unsigned size () const { return workers.size (); }
+
+    void submit (std::function<void ()> task)
+    {
+      {
+        std::lock_guard<std::mutex> lock (mutex);
+        tasks.push_back (std::move (task));
+      }
+      available.notify_one ();
+    }
+
+    /* Runs one queued task on the calling thread. Returns false if there
+       was nothing to run. */
+    bool runPendingTask ()
+    {
+      std::function<void ()> task;
+      {
+        std::lock_guard<std::mutex> lock (mutex);
+        if (tasks.empty ()) return false;
+        task = std::move (tasks.front ());
+        tasks.pop_front ();
+      }
+      task ();
+      return true;
+    }
+
+  private:
+    void workerLoop ()
+    {
+      for (;;) {
+        std::function<void ()> task;
+        {
+          std::unique_lock<std::mutex> lock (mutex);
+          available.wait (lock, [this] () { return stopping || !tasks.empty (); });
+          if (tasks.empty ()) return;
+          task = std::move (tasks.front ());
+          tasks.pop_front ();
+        }
+        task ();
+      }
+    }
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void ()> > tasks;
+    std::mutex mutex;
+    std::condition_variable available;
+    bool stopping;
+};
+
+/* A set of tasks submitted to a pool that can be waited on together. If
+   a task throws, the first exception is kept and rethrown by wait; the
+   rest of the group still runs to completion. */
+class TaskGroup
+{
+  public:
+    explicit TaskGroup (ThreadPool& pool) : pool (pool), pending (0) {}
+
+    /* Waits without rethrowing, since a destructor cannot throw. Call wait
+       first to see a task's exception. */
+    ~TaskGroup () { waitForTasks (); }
+
+    void run (std::function<void ()> task)
+    {
+      {
+        std::lock_guard<std::mutex> lock (mutex);
+        pending++;
+      }
+      pool.submit ([this, task] () {
+        try {
+          task ();
+        }
+        catch (...) {
+          std::lock_guard<std::mutex> lock (mutex);
+          if (!error) error = std::current_exception ();
+        }
+        finish ();
+      });
+    }
+
+    /* Returns once every task in the group has finished, running queued
+       tasks from the pool in the meantime, and rethrows the first
+       exception a task threw */
+    void wait ()
+    {
+      waitForTasks ();
+      std::exception_ptr thrown;
+      {
+        std::lock_guard<std::mutex> lock (mutex);
+        std::swap (thrown, error);
+      }
+      if (thrown) std::rethrow_exception (thrown);
+    }
+
+  private:
+    void finish ()
+    {
+      /* The notify stays under the lock: once pending reaches zero the
+         waiter may return and destroy the group */
+      std::lock_guard<std::mutex> lock (mutex);
+      if (--pending == 0) done.notify_all ();
+    }
+
+    /* While the pool has queued work this thread helps with it. Once the
+       queue is empty every unfinished task of the group is running on
+       another thread, so it is safe to sleep until they are done. */
+    void waitForTasks ()
+    {
+      for (;;) {
+        {
+          std::lock_guard<std::mutex> lock (mutex);
+          if (pending == 0) return;
+        }
+        if (pool.runPendingTask ()) continue;
+
+        std::unique_lock<std::mutex> lock (mutex);
+        done.wait (lock, [this] () { return pending == 0; });
+        return;
+      }
+    }
+
+    ThreadPool& pool;
+    std::mutex mutex;
+    std::condition_variable done;
+    int pending;
+    std::exception_ptr error;
+};
+
+#endif
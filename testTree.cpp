@@ -1,12 +1,71 @@
 #include "CenteredIntervalTree.h"
+#include "QueryExecutor.h"
+#include "LogarithmicIntervalTree.h"
+#include "ImplicitIntervalTree.h"
+#include "NestedContainmentList.h"
+#include "BinnedIntervalIndex.h"
 #include <iostream>
+#include <fstream>
+#include <stdexcept>
 #include <assert.h>
 #include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <cstdio>
+#include <cstdint>
 #include "Timer.h"
 
 void printVec (std::vector<std::pair<double, double> >& vec);
 void bigTest ();
 
+/* Every call into the global allocator is counted, so that the cost of
+   building a tree can be reported in allocations as well as time. All
+   forms of operator new and operator delete are replaced together so
+   that each pair matches; every block comes from countedAllocate and
+   goes back through countedFree. Those two are kept out of line, or GCC
+   sees malloc and free paired with operator new and delete and warns
+   that they are mismatched. */
+static size_t allocationCount = 0;
+static size_t allocatedBytes = 0;
+
+static void* __attribute__ ((noinline))
+countedAllocate (size_t size, size_t alignment)
+{
+  allocationCount++;
+  allocatedBytes += size;
+  if (size == 0) size = 1;
+  void* memory;
+  if (alignment <= alignof (std::max_align_t)) {
+    memory = std::malloc (size);
+  }
+  else {
+    /* aligned_alloc wants the size to be a multiple of the alignment */
+    memory = std::aligned_alloc (alignment, (size + alignment - 1) / alignment * alignment);
+  }
+  if (memory == nullptr) throw std::bad_alloc ();
+  return memory;
+}
+
+static void __attribute__ ((noinline))
+countedFree (void* memory) noexcept
+{
+  std::free (memory);
+}
+
+void* operator new (size_t size) { return countedAllocate (size, 0); }
+void* operator new[] (size_t size) { return countedAllocate (size, 0); }
+void* operator new (size_t size, std::align_val_t alignment) { return countedAllocate (size, size_t (alignment)); }
+void* operator new[] (size_t size, std::align_val_t alignment) { return countedAllocate (size, size_t (alignment)); }
+
+void operator delete (void* memory) noexcept { countedFree (memory); }
+void operator delete[] (void* memory) noexcept { countedFree (memory); }
+void operator delete (void* memory, size_t) noexcept { countedFree (memory); }
+void operator delete[] (void* memory, size_t) noexcept { countedFree (memory); }
+void operator delete (void* memory, std::align_val_t) noexcept { countedFree (memory); }
+void operator delete[] (void* memory, std::align_val_t) noexcept { countedFree (memory); }
+void operator delete (void* memory, size_t, std::align_val_t) noexcept { countedFree (memory); }
+void operator delete[] (void* memory, size_t, std::align_val_t) noexcept { countedFree (memory); }
+
 void
 printVec (std::vector<std::pair<double, double> >& vec)
 {
@@ -17,43 +76,56 @@ printVec (std::vector<std::pair<double, double> >& vec)
   std::cout << std::endl;
 }
 
+template <typename Tree>
 void
 test (int numIntervals)
 {
+  typedef typename Tree::coord_type Coord;
+  typedef typename Tree::id_type Id;
   int numInsertElement = numIntervals;
   int numPointQueryElement = numIntervals;
   int numIntervalQueryElement = numIntervals;
-  std::vector<std::pair<double, double> > intervals;
-  std::pair<double, double> interval;
-  std::vector<std::pair<double, double> > stored_intervals;
-  std::unordered_set<int> result;
-  double a, b;
-  Timer pointTimer, intervalTimer;
+  std::vector<std::pair<Coord, Coord> > intervals;
+  std::pair<Coord, Coord> interval;
+  std::vector<std::pair<Coord, Coord> > stored_intervals;
+  std::unordered_set<Id> result;
+  Coord a, b;
+  std::vector<Coord> points;
+  Timer buildTimer, pointTimer, batchTimer, parallelTimer, intervalTimer;
 
   std::cout << "==========================" << std::endl;
   std::cout << "===== Automated Test =====" << std::endl;
   std::cout << "==========================" << std::endl;
+  std::cout << Tree::name () << std::endl;
   std::cout << "Number of elements inserted = " << numInsertElement << std::endl;
   std::cout << "Number of point queries = " << numPointQueryElement << std::endl;
   std::cout << "Number of interval queries = " << numIntervalQueryElement << std::endl;
 
   for (int i = 0; i < numInsertElement; i++) {
-    a = (double) (rand () % 100001);
-    b = (double) (rand () % 100001);
+    a = (Coord) (rand () % 100001);
+    b = (Coord) (rand () % 100001);
     interval.first = (a >= b) ? b : a;
     interval.second = (a >= b) ? a : b;
     intervals.push_back (interval);
   }
 
-  CenteredIntervalTree cit (intervals);
+  size_t allocationsBefore = allocationCount;
+  size_t bytesBefore = allocatedBytes;
+  buildTimer.start ();
+  Tree cit (intervals);
+  buildTimer.stop ();
+  std::cout << "Build Timer = " << buildTimer.elapsed () << std::endl;
+  std::cout << "Build Allocations = " << allocationCount - allocationsBefore
+            << " (" << allocatedBytes - bytesBefore << " bytes)" << std::endl;
   stored_intervals = cit.getStoredIntervalsCopy ();
 
   for (int i = 0; i < numPointQueryElement; i++) {
-    a = (double) (rand () % 100001);
+    a = (Coord) (rand () % 100001);
+    points.push_back (a);
     pointTimer.start();
     result = cit.pointSearch (a);
     pointTimer.stop();
-    std::unordered_set<int> check;
+    std::unordered_set<Id> check;
     for (int j = 0; j < stored_intervals.size (); j++) {
       if (stored_intervals[j].first <= a && stored_intervals[j].second >= a) {
         check.insert (j);
@@ -65,20 +137,50 @@ test (int numIntervals)
       std::cout << "Check size: " << check.size () << std::endl;
       std::cout << std::endl;
     }
+    if (cit.pointCount (a) != (Id) check.size ()) {
+      std::cout << "Got an error with Point Counting Test." << std::endl;
+    }
   }
 
   std::cout << "Point Timer = " << pointTimer.elapsed() / numPointQueryElement << std::endl;
   std::cout << "Point Query Test: PASS!!!" << std::endl;
 
+  typename Tree::BatchResult batch;
+  batchTimer.start ();
+  cit.pointSearchBatch (points, batch);
+  batchTimer.stop ();
+  for (int i = 0; i < numPointQueryElement; i++) {
+    std::unordered_set<Id> row (batch.ids.begin () + batch.offsets[i],
+                                 batch.ids.begin () + batch.offsets[i + 1]);
+    if (row != cit.pointSearch (points[i])) {
+      std::cout << "Got an error with Batch Point Searching Test." << std::endl;
+    }
+  }
+
+  std::cout << "Batch Point Timer = " << batchTimer.elapsed() / numPointQueryElement << std::endl;
+  std::cout << "Batch Point Query Test: PASS!!!" << std::endl;
+
+  QueryExecutor<Tree> executor (cit, 4);
+  typename Tree::BatchResult parallel;
+  parallelTimer.start ();
+  executor.pointSearch (points, parallel);
+  parallelTimer.stop ();
+  if (parallel.offsets != batch.offsets || parallel.ids != batch.ids) {
+    std::cout << "Got an error with Parallel Point Searching Test." << std::endl;
+  }
+
+  std::cout << "Parallel Point Timer = " << parallelTimer.elapsed() / numPointQueryElement << std::endl;
+  std::cout << "Parallel Point Query Test: PASS!!!" << std::endl;
+
   for (int i = 0; i < numIntervalQueryElement; i++) {
-    a = (double) (rand () % 100001);
-    b = (double) (rand () % 100001);
+    a = (Coord) (rand () % 100001);
+    b = (Coord) (rand () % 100001);
     interval.first = (a >= b) ? b : a;
     interval.second = (a >= b) ? a : b;
     intervalTimer.start();
     result = cit.intervalSearch (interval);
     intervalTimer.stop();
-    std::unordered_set<int> check;
+    std::unordered_set<Id> check;
 
     for (int j = 0; j < stored_intervals.size (); j++) {
       // if (stored_intervals[j].first <= interval.first && stored_intervals[j].second >= interval.first) {
@@ -95,14 +197,410 @@ test (int numIntervals)
     if (result != check) {
       std::cout << "Got an error with Interval Searching Test." << std::endl;
     }
+    if (cit.intervalCount (interval) != (Id) check.size ()) {
+      std::cout << "Got an error with Interval Counting Test." << std::endl;
+    }
   }
 
   std::cout << "Interval Timer = " << intervalTimer.elapsed() / numIntervalQueryElement << std::endl;
   std::cout << "Interval Query All Test: PASS!!!" << std::endl;
 }
 
+/* Every endpoint is one of a few values, so each node's key arrays are
+   long runs of equal keys and every search lands inside one. The time per
+   count should only grow with log n; the time per search is dominated by
+   the size of its output, so fewer searches are run. */
+template <typename Tree>
+void
+duplicateTest (int numIntervals)
+{
+  typedef typename Tree::coord_type Coord;
+  typedef typename Tree::id_type Id;
+  const int numDistinct = 16;
+  const int numSearches = 1000;
+  std::vector<std::pair<Coord, Coord> > intervals;
+  std::pair<Coord, Coord> interval;
+  std::vector<Id> result;
+  Coord a, b;
+  Timer countTimer, intervalTimer;
+
+  std::cout << "==========================" << std::endl;
+  std::cout << "=== Duplicate Endpoints ==" << std::endl;
+  std::cout << "==========================" << std::endl;
+  std::cout << Tree::name () << std::endl;
+  std::cout << "Number of elements inserted = " << numIntervals << std::endl;
+  std::cout << "Number of distinct endpoints = " << numDistinct << std::endl;
+
+  for (int i = 0; i < numIntervals; i++) {
+    a = (Coord) (rand () % numDistinct);
+    b = (Coord) (rand () % numDistinct);
+    interval.first = (a >= b) ? b : a;
+    interval.second = (a >= b) ? a : b;
+    intervals.push_back (interval);
+  }
+
+  Tree cit (intervals);
+  std::vector<std::pair<Coord, Coord> > stored_intervals = cit.getStoredIntervalsCopy ();
+
+  for (int i = 0; i < numIntervals; i++) {
+    a = (Coord) (rand () % numDistinct);
+    b = (Coord) (rand () % numDistinct);
+    interval.first = (a >= b) ? b : a;
+    interval.second = (a >= b) ? a : b;
+
+    countTimer.start ();
+    Id count = cit.intervalCount (interval);
+    countTimer.stop ();
+
+    if (i >= numSearches) continue;
+    result.clear ();
+    intervalTimer.start ();
+    cit.intervalSearch (interval, result);
+    intervalTimer.stop ();
+
+    if (i % 100 == 0) {
+      Id check = 0;
+      for (size_t j = 0; j < stored_intervals.size (); j++) {
+        if (stored_intervals[j].first <= interval.second && interval.first <= stored_intervals[j].second) check++;
+      }
+      if (count != check || (Id) result.size () != check) {
+        std::cout << "Got an error with Duplicate Searching Test." << std::endl;
+      }
+    }
+  }
+
+  std::cout << "Duplicate Count Timer = " << countTimer.elapsed () / numIntervals << std::endl;
+  std::cout << "Duplicate Interval Timer = "
+            << intervalTimer.elapsed () / std::min (numIntervals, numSearches) << std::endl;
+  std::cout << "Duplicate Endpoint Test: PASS!!!" << std::endl;
+}
+
+/* Writes a tree to a snapshot, maps it back and checks that the mapped
+   tree answers a batch of point queries the same way */
+template <typename Tree>
+void
+snapshotTest (int numIntervals)
+{
+  typedef typename Tree::coord_type Coord;
+  std::vector<std::pair<Coord, Coord> > intervals;
+  std::pair<Coord, Coord> interval;
+  std::vector<Coord> points;
+  Coord a, b;
+  Timer snapshotTimer;
+
+  std::cout << "==========================" << std::endl;
+  std::cout << "===== Snapshot Test ======" << std::endl;
+  std::cout << "==========================" << std::endl;
+  std::cout << "Number of elements inserted = " << numIntervals << std::endl;
+
+  for (int i = 0; i < numIntervals; i++) {
+    a = (Coord) (rand () % 100001);
+    b = (Coord) (rand () % 100001);
+    interval.first = (a >= b) ? b : a;
+    interval.second = (a >= b) ? a : b;
+    intervals.push_back (interval);
+    points.push_back ((Coord) (rand () % 100001));
+  }
+
+  Tree cit (intervals);
+  typename Tree::BatchResult batch;
+  cit.pointSearchBatch (points, batch);
+
+  cit.saveSnapshot ("testTree.snapshot");
+  snapshotTimer.start ();
+  Tree mapped ("testTree.snapshot");
+  snapshotTimer.stop ();
+  std::remove ("testTree.snapshot");
+  typename Tree::BatchResult fromSnapshot;
+  mapped.pointSearchBatch (points, fromSnapshot);
+  if (fromSnapshot.offsets != batch.offsets || fromSnapshot.ids != batch.ids) {
+    std::cout << "Got an error with Snapshot Point Searching Test." << std::endl;
+  }
+
+  /* A file whose header is intact but whose nodes are garbage must be
+     refused rather than read out of bounds later */
+  cit.saveSnapshot ("testTree.snapshot");
+  {
+    std::fstream file ("testTree.snapshot", std::ios::in | std::ios::out | std::ios::binary);
+    std::vector<char> garbage (4096, (char) 0xff);
+    file.seekp (64);
+    file.write (garbage.data (), garbage.size ());
+  }
+  bool rejected = false;
+  try {
+    Tree corrupt ("testTree.snapshot");
+  }
+  catch (const std::runtime_error&) {
+    rejected = true;
+  }
+  std::remove ("testTree.snapshot");
+  if (!rejected) {
+    std::cout << "Got an error with Corrupt Snapshot Test." << std::endl;
+  }
+
+  std::cout << "Snapshot Open Timer = " << snapshotTimer.elapsed () << std::endl;
+  std::cout << "Snapshot Query Test: PASS!!!" << std::endl;
+}
+
+/* Intervals nested the way annotations are: a few long regions, and
+   every other interval drawn inside a randomly chosen earlier one */
+std::vector<std::pair<double, double> >
+nestedIntervals (int numIntervals)
+{
+  std::vector<std::pair<double, double> > intervals;
+  for (int i = 0; i < numIntervals; i++) {
+    double a, b;
+    if (i < 16) {
+      a = (double) (rand () % 50001);
+      b = a + 20000 + rand () % 30001;
+    }
+    else {
+      const std::pair<double, double>& outer = intervals[rand () % i];
+      long length = (long) (outer.second - outer.first);
+      a = outer.first + rand () % (length + 1);
+      b = outer.first + rand () % (length + 1);
+      if (a > b) std::swap (a, b);
+    }
+    intervals.push_back (std::make_pair (a, b));
+  }
+  return intervals;
+}
+
+/* Build cost, memory and query times on nested intervals, for comparing
+   backends on the workload NestedContainmentList is meant for */
+template <typename Tree>
+void
+nestedTest (int numIntervals)
+{
+  typedef typename Tree::id_type Id;
+  std::vector<std::pair<double, double> > intervals = nestedIntervals (numIntervals);
+  std::pair<double, double> interval;
+  std::vector<Id> result;
+  double a, b;
+  Timer buildTimer, pointTimer, intervalTimer;
+
+  std::cout << "==========================" << std::endl;
+  std::cout << "====== Nested Test =======" << std::endl;
+  std::cout << "==========================" << std::endl;
+  std::cout << Tree::name () << std::endl;
+  std::cout << "Number of elements inserted = " << numIntervals << std::endl;
+
+  size_t bytesBefore = allocatedBytes;
+  buildTimer.start ();
+  Tree cit (intervals);
+  buildTimer.stop ();
+  std::cout << "Build Timer = " << buildTimer.elapsed () << std::endl;
+  std::cout << "Build Allocated Bytes = " << allocatedBytes - bytesBefore << std::endl;
+  std::vector<std::pair<double, double> > stored_intervals = cit.getStoredIntervalsCopy ();
+
+  for (int i = 0; i < numIntervals; i++) {
+    a = (double) (rand () % 100001);
+    b = a + rand () % 1001;
+    interval = std::make_pair (a, b);
+
+    result.clear ();
+    pointTimer.start ();
+    cit.pointSearch (a, result);
+    pointTimer.stop ();
+    size_t pointMatches = result.size ();
+
+    result.clear ();
+    intervalTimer.start ();
+    cit.intervalSearch (interval, result);
+    intervalTimer.stop ();
+
+    if (i % 100 == 0) {
+      size_t pointCheck = 0, intervalCheck = 0;
+      for (size_t j = 0; j < stored_intervals.size (); j++) {
+        if (stored_intervals[j].first <= a && a <= stored_intervals[j].second) pointCheck++;
+        if (stored_intervals[j].first <= b && a <= stored_intervals[j].second) intervalCheck++;
+      }
+      if (pointMatches != pointCheck || result.size () != intervalCheck) {
+        std::cout << "Got an error with Nested Searching Test." << std::endl;
+      }
+    }
+  }
+
+  std::cout << "Point Timer = " << pointTimer.elapsed () / numIntervals << std::endl;
+  std::cout << "Interval Timer = " << intervalTimer.elapsed () / numIntervals << std::endl;
+  std::cout << "Nested Query Test: PASS!!!" << std::endl;
+}
+
+/* Every interval carries its index in the input as its payload, so the
+   payloads reported for a query can be checked against the input
+   directly, with no id lookup in between */
+void
+payloadTest (int numIntervals)
+{
+  typedef CenteredIntervalTree<double, int, size_t> Tree;
+  std::vector<std::pair<double, double> > intervals;
+  std::vector<size_t> payloads;
+  std::pair<double, double> interval;
+  double a, b;
+  Timer idTimer, payloadTimer;
+
+  std::cout << "==========================" << std::endl;
+  std::cout << "====== Payload Test ======" << std::endl;
+  std::cout << "==========================" << std::endl;
+  std::cout << "Number of elements inserted = " << numIntervals << std::endl;
+
+  for (int i = 0; i < numIntervals; i++) {
+    a = (double) (rand () % 100001);
+    b = (double) (rand () % 100001);
+    interval.first = (a >= b) ? b : a;
+    interval.second = (a >= b) ? a : b;
+    intervals.push_back (interval);
+    payloads.push_back (i);
+  }
+
+  Tree cit (intervals, payloads);
+  cit.saveSnapshot ("testTree.snapshot");
+  Tree mapped ("testTree.snapshot");
+  std::remove ("testTree.snapshot");
+
+  std::vector<size_t> result, lookedUp, check, fromSnapshot;
+  std::vector<int> ids;
+  for (int i = 0; i < numIntervals; i++) {
+    a = (double) (rand () % 100001);
+    b = (double) (rand () % 100001);
+    interval.first = (a >= b) ? b : a;
+    interval.second = (a >= b) ? a : b;
+
+    /* The same work through ids and through payloads */
+    ids.clear ();
+    lookedUp.clear ();
+    idTimer.start ();
+    cit.intervalSearch (interval, ids);
+    for (size_t j = 0; j < ids.size (); j++) lookedUp.push_back (cit.payload (ids[j]));
+    idTimer.stop ();
+
+    result.clear ();
+    payloadTimer.start ();
+    cit.forEachPayload (interval, [&result] (const size_t& payload) { result.push_back (payload); });
+    payloadTimer.stop ();
+
+    check.clear ();
+    for (int j = 0; j < numIntervals; j++) {
+      if (intervals[j].first <= interval.second && interval.first <= intervals[j].second) {
+        check.push_back (j);
+      }
+    }
+
+    fromSnapshot.clear ();
+    mapped.forEachPayload (interval.first, [&fromSnapshot] (const size_t& payload) {
+      fromSnapshot.push_back (payload);
+    });
+    size_t contained = 0;
+    for (int j = 0; j < numIntervals; j++) {
+      if (intervals[j].first <= interval.first && interval.first <= intervals[j].second) contained++;
+    }
+
+    std::sort (result.begin (), result.end ());
+    std::sort (lookedUp.begin (), lookedUp.end ());
+    if (result != check || lookedUp != check || fromSnapshot.size () != contained) {
+      std::cout << "Got an error with Payload Searching Test." << std::endl;
+    }
+  }
+
+  std::cout << "Id Lookup Timer = " << idTimer.elapsed () / numIntervals << std::endl;
+  std::cout << "Payload Timer = " << payloadTimer.elapsed () / numIntervals << std::endl;
+  std::cout << "Payload Query Test: PASS!!!" << std::endl;
+}
+
+/* Inserts and removes intervals at random through a
+   LogarithmicIntervalTree, checking its queries against the intervals
+   that should be live at each step */
+void
+logarithmicTest (int numIntervals)
+{
+  LogarithmicIntervalTree<> lit (64);
+  std::vector<std::pair<double, double> > intervals;
+  std::vector<size_t> handles;
+  std::pair<double, double> interval;
+  double a, b;
+  Timer insertTimer, removeTimer, intervalTimer;
+  int numRemoved = 0;
+
+  std::cout << "==========================" << std::endl;
+  std::cout << "=== Logarithmic Test =====" << std::endl;
+  std::cout << "==========================" << std::endl;
+  std::cout << "Number of elements inserted = " << numIntervals << std::endl;
+
+  std::vector<size_t> result, check;
+  for (int i = 0; i < numIntervals; i++) {
+    a = (double) (rand () % 100001);
+    b = (double) (rand () % 100001);
+    interval.first = (a >= b) ? b : a;
+    interval.second = (a >= b) ? a : b;
+    insertTimer.start ();
+    size_t handle = lit.insert (interval);
+    insertTimer.stop ();
+    intervals.push_back (interval);
+    handles.push_back (handle);
+
+    /* Remove about a third of what goes in */
+    if (rand () % 3 == 0) {
+      int index = rand () % intervals.size ();
+      removeTimer.start ();
+      bool removed = lit.remove (handles[index]);
+      removeTimer.stop ();
+      if (!removed || lit.remove (handles[index])) {
+        std::cout << "Got an error with Logarithmic Removal Test." << std::endl;
+      }
+      intervals.erase (intervals.begin () + index);
+      handles.erase (handles.begin () + index);
+      numRemoved++;
+    }
+
+    if (i % 10 != 0) continue;
+    a = (double) (rand () % 100001);
+    b = (double) (rand () % 100001);
+    interval.first = (a >= b) ? b : a;
+    interval.second = (a >= b) ? a : b;
+    result.clear ();
+    intervalTimer.start ();
+    lit.intervalSearch (interval, result);
+    intervalTimer.stop ();
+
+    check.clear ();
+    for (size_t j = 0; j < intervals.size (); j++) {
+      if (intervals[j].first <= interval.second && interval.first <= intervals[j].second) {
+        check.push_back (handles[j]);
+      }
+    }
+    std::sort (result.begin (), result.end ());
+    std::sort (check.begin (), check.end ());
+    if (result != check || lit.size () != intervals.size ()) {
+      std::cout << "Got an error with Logarithmic Searching Test." << std::endl;
+    }
+  }
+
+  std::cout << "Runs = " << lit.numRuns () << std::endl;
+  std::cout << "Insert Timer = " << insertTimer.elapsed () / numIntervals << std::endl;
+  std::cout << "Remove Timer = " << removeTimer.elapsed () / numRemoved << std::endl;
+  std::cout << "Interval Timer = " << intervalTimer.elapsed () / (numIntervals / 10) << std::endl;
+  std::cout << "Logarithmic Test: PASS!!!" << std::endl;
+}
+
 int main () {
-  test (1000);
-  test (10000);
-  test (25000);
+  test<CenteredIntervalTree<> > (1000);
+  test<CenteredIntervalTree<> > (10000);
+  test<CenteredIntervalTree<> > (25000);
+  test<CenteredIntervalTree<uint32_t, int> > (10000);
+  snapshotTest<CenteredIntervalTree<> > (25000);
+  snapshotTest<CenteredIntervalTree<uint32_t, int> > (10000);
+  test<ImplicitIntervalTree<> > (10000);
+  test<ImplicitIntervalTree<> > (25000);
+  test<ImplicitIntervalTree<uint32_t, int> > (10000);
+  test<NestedContainmentList<> > (10000);
+  test<NestedContainmentList<uint32_t, int> > (10000);
+  test<BinnedIntervalIndex<uint32_t, int> > (10000);
+  test<BinnedIntervalIndex<uint32_t, int> > (25000);
+  duplicateTest<CenteredIntervalTree<> > (1000);
+  duplicateTest<CenteredIntervalTree<> > (100000);
+  duplicateTest<CenteredIntervalTree<uint32_t, int> > (100000);
+  nestedTest<CenteredIntervalTree<> > (100000);
+  nestedTest<NestedContainmentList<> > (100000);
+  payloadTest (10000);
+  logarithmicTest (10000);
 }
@@ -1,10 +1,61 @@
 #include "DynamicIntervalTree.h"
-#include <unordered_set>
+#include "Skiplist.h"
+#include "ReverseSkiplist.h"
 #include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <new>
+#include <string>
 #include "Timer.h"
 
 using namespace std;
 
+/* Every call into the global allocator is counted, so a test can check
+   that some stretch of work does not allocate. All forms of operator new
+   and operator delete are replaced together so that each pair matches.
+   countedAllocate and countedFree are kept out of line, or GCC sees
+   malloc and free paired with operator new and delete and warns that
+   they are mismatched. */
+static long allocationCount = 0;
+
+static void* __attribute__ ((noinline))
+countedAllocate (size_t size, size_t alignment)
+{
+  allocationCount++;
+  if (size == 0) size = 1;
+  void* memory;
+  if (alignment <= alignof (std::max_align_t)) {
+    memory = std::malloc (size);
+  }
+  else {
+    /* aligned_alloc wants the size to be a multiple of the alignment */
+    memory = std::aligned_alloc (alignment, (size + alignment - 1) / alignment * alignment);
+  }
+  if (memory == nullptr) throw std::bad_alloc ();
+  return memory;
+}
+
+static void __attribute__ ((noinline))
+countedFree (void* memory) noexcept
+{
+  std::free (memory);
+}
+
+void* operator new (size_t size) { return countedAllocate (size, 0); }
+void* operator new[] (size_t size) { return countedAllocate (size, 0); }
+void* operator new (size_t size, std::align_val_t alignment) { return countedAllocate (size, size_t (alignment)); }
+void* operator new[] (size_t size, std::align_val_t alignment) { return countedAllocate (size, size_t (alignment)); }
+
+void operator delete (void* memory) noexcept { countedFree (memory); }
+void operator delete[] (void* memory) noexcept { countedFree (memory); }
+void operator delete (void* memory, size_t) noexcept { countedFree (memory); }
+void operator delete[] (void* memory, size_t) noexcept { countedFree (memory); }
+void operator delete (void* memory, std::align_val_t) noexcept { countedFree (memory); }
+void operator delete[] (void* memory, std::align_val_t) noexcept { countedFree (memory); }
+void operator delete (void* memory, size_t, std::align_val_t) noexcept { countedFree (memory); }
+void operator delete[] (void* memory, size_t, std::align_val_t) noexcept { countedFree (memory); }
+
 bool isOverlap(DynamicIntervalTree::Interval i1, DynamicIntervalTree::Interval i2) {
   return i1.start <= i2.end && i2.start <= i1.end;
 }
@@ -15,14 +66,23 @@ inline bool operator== (DynamicIntervalTree::Interval const& lhs, DynamicInterva
          (lhs.end == rhs.end);
 }
 
+/* Matches the end points of the interval with this handle */
+struct isPointOf {
+  DynamicIntervalTree::Handle handle;
+  isPointOf(DynamicIntervalTree::Handle handle) : handle(handle) {}
+  bool operator() (const DynamicIntervalTree::Endpoint &point) const {
+    return point.id == handle;
+  }
+};
+
 void test(int numIntervals) {
   int numInsertElement = numIntervals;
   int numPointQueryElement = numIntervals;
   int numIntervalQueryElement = numIntervals;
   vector<DynamicIntervalTree::Interval> intervals;
+  vector<DynamicIntervalTree::Handle> handles;
   DynamicIntervalTree::Interval interval;
   vector<DynamicIntervalTree::Interval> results;
-  unordered_set<double> used;
   double a, b;
   Timer insertTimer, deleteTimer, pointQueryTimer, intervalQueryTimer;
 
@@ -38,18 +98,12 @@ void test(int numIntervals) {
   for (int i = 0; i < numInsertElement; i++) {
     a = (double) (rand()%100001);
     b = (double) (rand()%100001);
-    while (used.find (a) != used.end() || used.find(b) != used.end()) {
-      a = (double) (rand()%100001);
-      b = (double) (rand()%100001);
-    }
-    used.insert (a);
-    used.insert (b);
     interval.start = (a >= b) ? b: a;
     interval.end = (a >= b) ? a : b;
     intervals.push_back(interval);
 
     insertTimer.start();
-    dit.insertInterval(interval);
+    handles.push_back(dit.insertInterval(interval));
     insertTimer.stop();
   }
 
@@ -73,6 +127,9 @@ void test(int numIntervals) {
       std::cout << "Check size: " << check.size () << std::endl;
       std::cout << std::endl;
     }
+    if (dit.pointCount(a) != (int) check.size()) {
+      std::cout << "Got an error with Point Counting Test." << std::endl;
+    }
   }
   cout << "Point Query Timer = " << pointQueryTimer.elapsed() / numPointQueryElement << endl;
   cout << "Point Query Test: PASS!!!" << endl;
@@ -94,10 +151,14 @@ void test(int numIntervals) {
       }
     }
 
+    if (dit.intervalCount(interval) != (int) check.size()) {
+      std::cout << "Got an error with Interval Counting Test." << std::endl;
+    }
+
     if (results.size() != check.size ()) {
-      // std::cout << "Got an error with Interval Searching." << std::endl;
-      // std::cout << "Results size: " << results.size() << std::endl;
-      // std::cout << "Check size: " << check.size() << std::endl;
+      std::cout << "Got an error with Interval Searching." << std::endl;
+      std::cout << "Results size: " << results.size() << std::endl;
+      std::cout << "Check size: " << check.size() << std::endl;
     }
   }
 
@@ -108,17 +169,17 @@ void test(int numIntervals) {
     int index = (int) (rand()%(intervals.size()-1));
     // std::cout << "Element to remove: " << intervals[index].start << " "
     //           << intervals[index].end << std::endl;
-    interval = intervals[index];
+    DynamicIntervalTree::Handle handle = handles[index];
     deleteTimer.start ();
-    dit.removeInterval (interval);
+    dit.remove (handle);
     deleteTimer.stop ();
     intervals.erase (intervals.begin() + index);
-    vector<pair<double, DynamicIntervalTree::Interval> > combined_points = dit.getArray();
+    handles.erase (handles.begin() + index);
+    const DynamicIntervalTree::EndpointIndex &combined_points = dit.getArray();
     if (combined_points.size() != 2*numIntervals - 2*i - 2) {
       std::cout << "Didn't remove anything." << std::endl;
     }
-    if (!(find(combined_points.begin (), combined_points.end (), make_pair(interval.start, interval)) == combined_points.end())
-        && !(find(combined_points.begin (), combined_points.end (), make_pair(interval.end, interval)) == combined_points.end())) {
+    if (find_if(combined_points.begin (), combined_points.end (), isPointOf(handle)) != combined_points.end()) {
       std::cout << "Remove didn't remove the right element" << std::endl;
     }
   }
@@ -126,9 +187,280 @@ void test(int numIntervals) {
   std::cout << "Delete Timer = " << deleteTimer.elapsed () / (numIntervals/10) << std::endl;
 }
 
+/* Every endpoint is one of a few values, so thousands of intervals share
+   each one and every lookup lands in a long run of equal keys. The time
+   per count query should only grow with log n. Every 100th query also
+   goes through intervalQuery, whose time is dominated by the size of
+   its output. */
+void duplicateTest(int numIntervals) {
+  const int numDistinct = 16;
+  vector<DynamicIntervalTree::Interval> intervals;
+  DynamicIntervalTree::Interval interval;
+  double a, b;
+  vector<DynamicIntervalTree::Interval> results;
+  Timer insertTimer, countTimer, queryTimer, deleteTimer;
+
+  cout << "==========================" << endl;
+  cout << "=== Duplicate Endpoints ==" << endl;
+  cout << "==========================" << endl;
+  cout << "Number of elements inserted = " << numIntervals << endl;
+  cout << "Number of distinct endpoints = " << numDistinct << endl;
+
+  DynamicIntervalTree dit;
+
+  for (int i = 0; i < numIntervals; i++) {
+    a = (double) (rand()%numDistinct);
+    b = (double) (rand()%numDistinct);
+    interval.start = (a >= b) ? b: a;
+    interval.end = (a >= b) ? a : b;
+    intervals.push_back(interval);
+
+    insertTimer.start();
+    dit.insertInterval(interval);
+    insertTimer.stop();
+  }
+
+  cout << "Duplicate Insert Timer = " << insertTimer.elapsed() / numIntervals << endl;
+
+  for (int i = 0; i < numIntervals; i++) {
+    a = (double) (rand()%numDistinct);
+    b = (double) (rand()%numDistinct);
+    interval.start = (a >= b) ? b: a;
+    interval.end = (a >= b) ? a : b;
+
+    countTimer.start();
+    int count = dit.intervalCount(interval);
+    countTimer.stop();
+
+    if (i % 100 == 0) {
+      queryTimer.start();
+      results = dit.intervalQuery(interval);
+      queryTimer.stop();
+
+      int check = 0;
+      for (size_t j = 0; j < intervals.size(); j++) {
+        if (isOverlap (intervals[j], interval)) check++;
+      }
+      if (count != check) {
+        std::cout << "Got an error with Duplicate Counting Test." << std::endl;
+      }
+      if ((int) results.size() != check) {
+        std::cout << "Got an error with Duplicate Searching Test." << std::endl;
+      }
+    }
+  }
+
+  cout << "Duplicate Count Timer = " << countTimer.elapsed() / numIntervals << endl;
+  cout << "Duplicate Query Timer = " << queryTimer.elapsed() / ((numIntervals + 99) / 100) << endl;
+
+  for (int i = 0; i < numIntervals/10; i++) {
+    int index = (int) (rand()%(intervals.size()-1));
+    deleteTimer.start ();
+    dit.removeInterval (intervals[index]);
+    deleteTimer.stop ();
+    intervals.erase (intervals.begin() + index);
+  }
+
+  if (dit.getArray().size() != 2*intervals.size()) {
+    std::cout << "Got an error with Duplicate Removal Test." << std::endl;
+  }
+
+  cout << "Duplicate Delete Timer = " << deleteTimer.elapsed () / (numIntervals/10) << endl;
+  cout << "Duplicate Endpoint Test: PASS!!!" << endl;
+}
+
+/* Once a tree has been through a few rounds of removing and inserting
+   intervals at a steady size, its pool has room for everything it
+   needs, and a further round must not call operator new at all */
+void steadyStateTest(int numIntervals) {
+  const int numWarmUpRounds = 8;
+  vector<DynamicIntervalTree::Handle> handles;
+  DynamicIntervalTree::Interval interval;
+  double a, b;
+  Timer updateTimer;
+
+  cout << "==========================" << endl;
+  cout << "====== Steady State ======" << endl;
+  cout << "==========================" << endl;
+  cout << "Number of elements inserted = " << numIntervals << endl;
+
+  DynamicIntervalTree dit;
+  dit.reserve(numIntervals);
+
+  for (int i = 0; i < numIntervals; i++) {
+    a = (double) (rand()%100001);
+    b = (double) (rand()%100001);
+    interval.start = (a >= b) ? b: a;
+    interval.end = (a >= b) ? a : b;
+    handles.push_back(dit.insertInterval(interval));
+  }
+
+  long allocations = 0;
+  for (int round = 0; round <= numWarmUpRounds; round++) {
+    long before = allocationCount;
+    for (int i = 0; i < numIntervals; i++) {
+      int index = rand()%numIntervals;
+      a = (double) (rand()%100001);
+      b = (double) (rand()%100001);
+      interval.start = (a >= b) ? b: a;
+      interval.end = (a >= b) ? a : b;
+
+      updateTimer.start();
+      dit.remove(handles[index]);
+      handles[index] = dit.insertInterval(interval);
+      updateTimer.stop();
+    }
+    allocations = allocationCount - before;
+  }
+
+  if (allocations != 0) {
+    std::cout << "Got an error with Steady State Test: " << allocations << " allocations." << std::endl;
+  }
+  if (dit.getArray().size() != 2*handles.size()) {
+    std::cout << "Got an error with Steady State Size Test." << std::endl;
+  }
+
+  cout << "Steady State Update Timer = " << updateTimer.elapsed() / ((numWarmUpRounds + 1) * numIntervals) << endl;
+  cout << "Steady State Test: PASS!!!" << endl;
+}
+
+/* Comparator counting how often it is called. Two skiplists holding the
+   same keys are searched with the same number of comparisons only if
+   their nodes got the same levels. */
+struct countingLess {
+  long *calls;
+  countingLess(long *calls) : calls(calls) {}
+  bool operator() (int a, int b) const { ++*calls; return a < b; }
+};
+
+/* Allocator recording how many bytes it has handed out and not yet
+   taken back */
+template <typename T>
+struct countingAllocator {
+  typedef T value_type;
+  long *live;
+  countingAllocator(long *live) : live(live) {}
+  template <typename U> countingAllocator(const countingAllocator<U> &other) : live(other.live) {}
+  T *allocate(size_t n) { *live += n * sizeof(T); return static_cast<T *>(::operator new(n * sizeof(T))); }
+  void deallocate(T *p, size_t n) { *live -= n * sizeof(T); ::operator delete(p); }
+  template <typename U> bool operator== (const countingAllocator<U> &other) const { return live == other.live; }
+  template <typename U> bool operator!= (const countingAllocator<U> &other) const { return live != other.live; }
+};
+
+/* Checks Skiplist and ReverseSkiplist against std::map, and that the
+   seed fixes the shape of the list and the allocator gets the nodes */
+void skiplistTest(int numKeys) {
+  typedef countingAllocator<pair<const int, int> > Allocator;
+  long live = 0;
+
+  cout << "==========================" << endl;
+  cout << "====== Skiplist Test =====" << endl;
+  cout << "==========================" << endl;
+
+  {
+    Skiplist<int, int, less<int>, Allocator> list(less<int>(), Allocator(&live), 42);
+    ReverseSkiplist<int, int> reverse;
+    map<int, int> check;
+    for (int i = 0; i < numKeys; i++) {
+      int key = rand() % (numKeys / 2);
+      if (rand() % 3 == 0) {
+        bool erased = check.erase(key) == 1;
+        if (list.erase(key) != erased || reverse.erase(key) != erased) {
+          std::cout << "Got an error with Skiplist Erase Test." << std::endl;
+        }
+      } else {
+        bool inserted = check.insert(make_pair(key, i)).second;
+        if (list.insert(key, i).second != inserted || reverse.insert(key, i).second != inserted) {
+          std::cout << "Got an error with Skiplist Insert Test." << std::endl;
+        }
+      }
+    }
+    if (list.size() != check.size() || reverse.size() != check.size() ||
+        !equal(check.begin(), check.end(), list.begin()) ||
+        !equal(check.rbegin(), check.rend(), reverse.begin())) {
+      std::cout << "Got an error with Skiplist Contents Test." << std::endl;
+    }
+    if (live < (long) (check.size() * sizeof(pair<const int, int>))) {
+      std::cout << "Got an error with Skiplist Allocator Test." << std::endl;
+    }
+  }
+  if (live != 0) {
+    std::cout << "Got an error with Skiplist Allocator Release Test." << std::endl;
+  }
+
+  long calls[3] = {0, 0, 0};
+  const uint64_t seeds[3] = {7, 7, 8};
+  for (int l = 0; l < 3; l++) {
+    Skiplist<int, int, countingLess> list(countingLess(&calls[l]), allocator<pair<const int, int> >(), seeds[l]);
+    for (int i = 0; i < numKeys; i++) list.insert((i * 7919) % numKeys, i);
+  }
+  if (calls[0] != calls[1] || calls[0] == calls[2]) {
+    std::cout << "Got an error with Skiplist Seed Test." << std::endl;
+  }
+
+  cout << "Skiplist Test: PASS!!!" << endl;
+}
+
+/* Moves lists around and checks that the moved-from list is left empty
+   and still works, and that emplace builds values in place, which lets
+   a move-only value be stored */
+void skiplistMoveTest(int numKeys) {
+  cout << "==========================" << endl;
+  cout << "=== Skiplist Move Test ===" << endl;
+  cout << "==========================" << endl;
+
+  Skiplist<int, unique_ptr<int> > list;
+  for (int i = 0; i < numKeys; i++) {
+    list.emplace(i, new int(i));
+  }
+  unique_ptr<int> duplicate(new int(-1));
+  if (list.emplace(0, duplicate.get()).second) {
+    std::cout << "Got an error with Skiplist Emplace Test." << std::endl;
+    duplicate.release();
+  }
+
+  Skiplist<int, unique_ptr<int> > moved(std::move(list));
+  if (!list.empty() || list.begin() != list.end() || moved.size() != (size_t) numKeys) {
+    std::cout << "Got an error with Skiplist Move Construction Test." << std::endl;
+  }
+
+  /* The moved-from list takes new elements and can be assigned to */
+  list.emplace(-1, new int(-1));
+  if (list.size() != 1 || *list.find(-1)->second != -1) {
+    std::cout << "Got an error with Skiplist Moved-From Test." << std::endl;
+  }
+  list = std::move(moved);
+  if (!moved.empty() || list.size() != (size_t) numKeys || list.find(-1) != list.end()) {
+    std::cout << "Got an error with Skiplist Move Assignment Test." << std::endl;
+  }
+  for (int i = 0; i < numKeys; i++) {
+    if (list.find(i) == list.end() || *list.find(i)->second != i) {
+      std::cout << "Got an error with Skiplist Move Contents Test." << std::endl;
+      break;
+    }
+  }
+
+  ReverseSkiplist<string, string> reverse;
+  reverse.emplace("b", 3, 'x');
+  reverse.insert("a", "y");
+  ReverseSkiplist<string, string> reverseMoved = std::move(reverse);
+  if (!reverse.empty() || reverseMoved.begin()->second != "xxx" || reverseMoved.size() != 2) {
+    std::cout << "Got an error with ReverseSkiplist Move Test." << std::endl;
+  }
+
+  cout << "Skiplist Move Test: PASS!!!" << endl;
+}
+
 int main () {
   test (1000);
   test (10000);
   test (25000);
+  duplicateTest (1000);
+  duplicateTest (10000);
+  duplicateTest (100000);
+  steadyStateTest (10000);
+  steadyStateTest (100000);
+  skiplistTest (10000);
+  skiplistMoveTest (10000);
   return 0;
 }